@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+
+#include "hashmap.hpp"
+
+/**
+ * @brief 分片加锁的并发哈希表：键按哈希分到 N 个分片 每个分片是一个 HashTable 加一把读写锁
+ * !不同分片上的操作完全并行 同一分片上读和读并行 写独占
+ * 读走 HashTable 的 const find 不推进渐进式 rehash 所以可以只持读锁
+ * 分片用混合后哈希的高位选 HashTable 内部用 hash % 桶数(低位) 两者不相关
+ * 否则 std::hash<int> 是恒等映射 同一分片里的键低位全相同 只会落到 1/N 的桶里
+ * 每个分片按缓存行对齐 避免相邻分片的锁互相伪共享
+ *
+ * 哈希只算一次：同一个值先选分片 再通过预计算哈希的重载交给分片里的 HashTable
+ * Hash / KeyEqual 透明时 (如 WyHash + std::equal_to<>) find / erase / compute_if_absent 接受 string_view 等异构键
+ *
+ * 接口不返回指向内部的指针(出了锁就可能被删) find 把值拷出来
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class ConcurrentHashMap {
+private:
+    using Table = HashTable<Key, Value, Hash, KeyEqual>;
+    static constexpr bool kTransparent =
+        hashmap_detail::IsTransparent<Hash>::value && hashmap_detail::IsTransparent<KeyEqual>::value;
+    template <typename K>
+    using key_arg = typename hashmap_detail::KeyArg<kTransparent>::template type<K, Key>;
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        Table table;
+        Shard(size_t initialSize, size_t incrementalStep) : table(initialSize, incrementalStep) {}
+    };
+
+    std::unique_ptr<std::unique_ptr<Shard>[]> shards_;
+    size_t shardBits_ = 0;
+    Hash hasher_;
+
+    Shard& shardFor(size_t hash) const {
+        if (shardBits_ == 0) return *shards_[0];
+        uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+        return *shards_[h >> (64 - shardBits_)];
+    }
+
+public:
+    // shards 向上取整到 2 的幂；incrementalStep 透传给每个分片的 HashTable (0 为同步 rehash)
+    explicit ConcurrentHashMap(size_t shards = 64, size_t initialSizePerShard = 16, size_t incrementalStep = 0) {
+        while ((size_t(1) << shardBits_) < shards) shardBits_++;
+        size_t n = size_t(1) << shardBits_;
+        shards_.reset(new std::unique_ptr<Shard>[n]);
+        for (size_t i = 0; i < n; i++) shards_[i] = std::make_unique<Shard>(initialSizePerShard, incrementalStep);
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+    template <typename K = Key>
+    std::optional<Value> find(const key_arg<K>& key) const {
+        size_t h = hasher_(key);
+        Shard& s = shardFor(h);
+        std::shared_lock<std::shared_mutex> lock(s.mutex);
+        const Table& table = s.table;
+        const Value* v = table.template find<K>(key, h);
+        return v ? std::optional<Value>(*v) : std::nullopt;
+    }
+
+    template <typename K = Key>
+    bool contains(const key_arg<K>& key) const { return find<K>(key).has_value(); }
+
+    // 插入或覆盖 新插入返回 true
+    bool insert_or_assign(const Key& key, const Value& value) {
+        size_t h = hasher_(key);
+        Shard& s = shardFor(h);
+        std::unique_lock<std::shared_mutex> lock(s.mutex);
+        size_t before = s.table.size();
+        s.table.insert(key, value, h);
+        return s.table.size() != before;
+    }
+
+    bool insert_or_assign(Key&& key, Value&& value) {
+        size_t h = hasher_(key);
+        Shard& s = shardFor(h);
+        std::unique_lock<std::shared_mutex> lock(s.mutex);
+        size_t before = s.table.size();
+        s.table.insert(std::move(key), std::move(value), h);
+        return s.table.size() != before;
+    }
+
+    template <typename K = Key>
+    bool erase(const key_arg<K>& key) {
+        size_t h = hasher_(key);
+        Shard& s = shardFor(h);
+        std::unique_lock<std::shared_mutex> lock(s.mutex);
+        return s.table.template erase<K>(key, h);
+    }
+
+    // 键存在直接返回它的值；不存在时调用 f() 生成值插入并返回
+    // 先持读锁查一次 命中就不碰写锁；未命中再拿写锁重查 并发的多个调用里 f 只会被执行一次
+    // f 在写锁内执行 不要在里面再访问同一个表
+    // 异构键只在真正插入时才构造 Key
+    template <typename K = Key, typename F>
+    Value compute_if_absent(const key_arg<K>& key, F&& f) {
+        size_t h = hasher_(key);
+        Shard& s = shardFor(h);
+        {
+            std::shared_lock<std::shared_mutex> lock(s.mutex);
+            const Table& table = s.table;
+            if (const Value* v = table.template find<K>(key, h)) return *v;
+        }
+        std::unique_lock<std::shared_mutex> lock(s.mutex);
+        if (Value* v = s.table.template find<K>(key, h)) return *v;
+        Value value = std::forward<F>(f)();
+        s.table.insert(Key(key), Value(value), h);
+        return value;
+    }
+
+    // 逐个分片加读锁求和 并发修改时只是一个近似值
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount(); i++) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i]->mutex);
+            total += shards_[i]->table.size();
+        }
+        return total;
+    }
+
+    size_t shardCount() const { return size_t(1) << shardBits_; }
+};
@@ -0,0 +1,114 @@
+// 并发哈希表基准：一把全局锁包住 HashTable (现在的用法) vs 分片读写锁 ConcurrentHashMap
+// 读多 (95% find / 5% 写) 和写多 (50% find / 50% 写) 两种混合 线程数从 1 增加到 N
+// 写操作一半 insert_or_assign 一半 erase 键随机取自 [0, kKeys) 表的大小稳定在一半左右
+//
+// 编译: g++ -std=c++17 -O2 -pthread -o concurrent_hashmap_bench concurrent_hashmap_bench.cpp
+// 运行: ./concurrent_hashmap_bench [最大线程数 默认 max(4, 核数)] [每项秒数 默认 1]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "concurrent_hashmap.hpp"
+
+static const uint64_t kKeys = 1 << 20;
+
+// 基线：外部一把 mutex
+struct LockedHashTable {
+    std::mutex mutex;
+    HashTable<uint64_t, uint64_t> table;
+    bool find(uint64_t k) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return table.find(k) != nullptr;
+    }
+    void insert_or_assign(uint64_t k, uint64_t v) {
+        std::lock_guard<std::mutex> lock(mutex);
+        table.insert(k, v);
+    }
+    void erase(uint64_t k) {
+        std::lock_guard<std::mutex> lock(mutex);
+        table.erase(k);
+    }
+};
+
+struct Sharded {
+    ConcurrentHashMap<uint64_t, uint64_t> map{64};
+    bool find(uint64_t k) { return map.find(k).has_value(); }
+    void insert_or_assign(uint64_t k, uint64_t v) { map.insert_or_assign(k, v); }
+    void erase(uint64_t k) { map.erase(k); }
+};
+
+static inline uint64_t xorshift(uint64_t& s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+// 返回总吞吐 (M ops/s)
+template <typename Map>
+double run(int threads, int writePercent, double seconds) {
+    Map m;
+    for (uint64_t k = 0; k < kKeys; k += 2) m.insert_or_assign(k, k);
+
+    std::atomic<bool> start{false}, stop{false};
+    std::vector<uint64_t> ops(threads * 8, 0);  // 每个线程的计数隔开一个缓存行
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            uint64_t rng = 0x9E3779B97F4A7C15ull * (t + 1);
+            uint64_t n = 0, hits = 0;
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                // 每 64 次操作看一次 stop
+                for (int i = 0; i < 64; i++) {
+                    uint64_t r = xorshift(rng);
+                    uint64_t key = r % kKeys;
+                    int dice = static_cast<int>((r >> 40) % 100);
+                    if (dice >= writePercent) {
+                        hits += m.find(key);
+                    } else if (dice & 1) {
+                        m.insert_or_assign(key, r);
+                    } else {
+                        m.erase(key);
+                    }
+                }
+                n += 64;
+            }
+            ops[t * 8] = n + (hits == 1 ? 1 : 0);
+        });
+    }
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    uint64_t total = 0;
+    for (int t = 0; t < threads; t++) total += ops[t * 8];
+    return total / elapsed / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    int hw = static_cast<int>(std::thread::hardware_concurrency());
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : std::max(4, hw);
+    double seconds = argc > 2 ? std::atof(argv[2]) : 1.0;
+
+    std::printf("%d hardware threads, %llu keys, %.1f s per cell, M ops/s\n", hw, (unsigned long long)kKeys, seconds);
+    const int mixes[] = {5, 50};
+    for (int writes : mixes) {
+        std::printf("\n%d%% reads / %d%% writes\n", 100 - writes, writes);
+        std::printf("%-8s %18s %18s\n", "threads", "mutex+HashTable", "ConcurrentHashMap");
+        for (int t = 1; t <= maxThreads; t *= 2) {
+            double locked = run<LockedHashTable>(t, writes, seconds);
+            double sharded = run<Sharded>(t, writes, seconds);
+            std::printf("%-8d %18.2f %18.2f\n", t, locked, sharded);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief 开放寻址的扁平哈希表 (Swiss table 风格)，接口与 HashTable 一致：insert / find / erase
+ * !所有键值对放在同一个连续数组里 没有链表节点 插入不分配内存(扩容除外) 查找不追指针
+ * 每个槽位配一个 1 字节控制字节：
+ *   kEmpty   (0x80) 空槽 探测到含空槽的组就可以停止
+ *   kDeleted (0xFE) 墓碑 删除留下的 探测要越过它继续找
+ *   0~127          占用 低 7 位是哈希的 H2 部分
+ * 哈希值拆成两部分：H1 = hash >> 7 决定从哪个组开始探测，H2 = hash & 0x7F 存进控制字节
+ * 控制字节按 16 个一组 SSE2 一条 _mm_cmpeq_epi8 同时比 16 个槽的 H2 只有 H2 相同的槽才真正比较键
+ * 组与组之间按三角数步长探测 (1, 2, 3... 组) 容量是 2 的幂时能遍历所有组
+ * 最大负载 7/8 墓碑也占用可用空间 growth_left_ 用完时墓碑多就原地重建 否则容量翻倍
+ * 扩容时键值对是移动过去的 不拷贝
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+private:
+    struct Slot {
+        Key key;
+        Value value;
+        template <typename K, typename V>
+        Slot(K&& k, V&& v) : key(std::forward<K>(k)), value(std::forward<V>(v)) {}
+    };
+
+    using ctrl_t = int8_t;
+    static constexpr ctrl_t kEmpty = -128;   // 0x80
+    static constexpr ctrl_t kDeleted = -2;   // 0xFE
+    static constexpr size_t kGroupWidth = 16;
+
+    // 一组 16 个控制字节 返回按位掩码：第 i 位为 1 表示第 i 个槽符合条件
+    struct Group {
+#if defined(__SSE2__)
+        __m128i ctrl;
+        explicit Group(const ctrl_t* p) : ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(p))) {}
+        uint32_t match(ctrl_t h2) const {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+        }
+        uint32_t matchEmpty() const { return match(kEmpty); }
+        // kEmpty 和 kDeleted 最高位都是 1 占用槽最高位是 0 movemask 正好取的是每个字节的最高位
+        uint32_t matchEmptyOrDeleted() const { return static_cast<uint32_t>(_mm_movemask_epi8(ctrl)); }
+#else
+        // 没有 SSE2 时逐字节比较 结果格式相同
+        const ctrl_t* ctrl;
+        explicit Group(const ctrl_t* p) : ctrl(p) {}
+        uint32_t match(ctrl_t h2) const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < kGroupWidth; i++) mask |= static_cast<uint32_t>(ctrl[i] == h2) << i;
+            return mask;
+        }
+        uint32_t matchEmpty() const { return match(kEmpty); }
+        uint32_t matchEmptyOrDeleted() const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < kGroupWidth; i++) mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+            return mask;
+        }
+#endif
+    };
+
+    ctrl_t* ctrl_ = nullptr;     // capacity_ 个控制字节 16 字节对齐
+    Slot* slots_ = nullptr;      // capacity_ 个槽位 只有控制字节为占用的槽里有构造好的对象
+    size_t capacity_ = 0;        // 0 或 2 的幂 且 >= kGroupWidth
+    size_t size_ = 0;
+    size_t growth_left_ = 0;     // 还能填多少个空槽(不含墓碑)才需要扩容或重建
+    Hash hasher_;
+    KeyEqual equal_;
+
+    // std::hash 对整数是恒等映射 低位和高位都不够随机 乘一个奇数常数再高低折叠
+    size_t hashOf(const Key& key) const {
+        uint64_t h = static_cast<uint64_t>(hasher_(key));
+        __uint128_t m = static_cast<__uint128_t>(h) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(static_cast<uint64_t>(m) ^ static_cast<uint64_t>(m >> 64));
+    }
+    static size_t h1(size_t hash) { return hash >> 7; }
+    static ctrl_t h2(size_t hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+
+    static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+    // 组起点对齐到 16 的倍数 每个组正好是一次对齐加载
+    size_t groupMask() const { return (capacity_ - 1) & ~(kGroupWidth - 1); }
+
+    // 找 key 所在的槽 找不到返回 capacity_
+    size_t findIndex(const Key& key, size_t hash) const {
+        if (capacity_ == 0) return 0;
+        size_t mask = groupMask();
+        size_t pos = h1(hash) & mask;
+        for (size_t step = kGroupWidth;; step += kGroupWidth) {
+            Group g(ctrl_ + pos);
+            for (uint32_t m = g.match(h2(hash)); m; m &= m - 1) {
+                size_t i = pos + __builtin_ctz(m);
+                if (equal_(slots_[i].key, key)) return i;
+            }
+            if (g.matchEmpty()) return capacity_;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // 沿探测序列找第一个空槽或墓碑 调用前保证表里至少有一个
+    size_t findFreeSlot(size_t hash) const {
+        size_t mask = groupMask();
+        size_t pos = h1(hash) & mask;
+        for (size_t step = kGroupWidth;; step += kGroupWidth) {
+            uint32_t m = Group(ctrl_ + pos).matchEmptyOrDeleted();
+            if (m) return pos + __builtin_ctz(m);
+            pos = (pos + step) & mask;
+        }
+    }
+
+    void allocate(size_t capacity) {
+        capacity_ = capacity;
+        ctrl_ = static_cast<ctrl_t*>(::operator new(capacity, std::align_val_t(kGroupWidth)));
+        std::memset(ctrl_, static_cast<unsigned char>(kEmpty), capacity);
+        slots_ = std::allocator<Slot>().allocate(capacity);
+        growth_left_ = maxLoad(capacity);
+    }
+
+    void deallocate() {
+        if (!ctrl_) return;
+        ::operator delete(ctrl_, std::align_val_t(kGroupWidth));
+        std::allocator<Slot>().deallocate(slots_, capacity_);
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        growth_left_ = 0;
+    }
+
+    void destroyAll() {
+        for (size_t i = 0; i < capacity_ && size_ > 0; i++) {
+            if (ctrl_[i] >= 0) {
+                slots_[i].~Slot();
+                size_--;
+            }
+        }
+    }
+
+    // 换一张 newCapacity 的新表 把所有元素移动过去 墓碑在这里被清掉
+    void resize(size_t newCapacity) {
+        ctrl_t* oldCtrl = ctrl_;
+        Slot* oldSlots = slots_;
+        size_t oldCapacity = capacity_;
+        ctrl_ = nullptr;
+        allocate(newCapacity);
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] < 0) continue;
+            size_t hash = hashOf(oldSlots[i].key);
+            size_t j = findFreeSlot(hash);
+            ctrl_[j] = h2(hash);
+            new (slots_ + j) Slot(std::move(oldSlots[i].key), std::move(oldSlots[i].value));
+            oldSlots[i].~Slot();
+        }
+        growth_left_ -= size_;
+        if (oldCtrl) {
+            ::operator delete(oldCtrl, std::align_val_t(kGroupWidth));
+            std::allocator<Slot>().deallocate(oldSlots, oldCapacity);
+        }
+    }
+
+    // 空槽用完了：元素不到一半上限说明大部分是墓碑 同容量重建即可 否则翻倍
+    void growOrCleanup() {
+        if (capacity_ == 0) {
+            resize(kGroupWidth);
+        } else if (size_ * 2 < maxLoad(capacity_)) {
+            resize(capacity_);
+        } else {
+            resize(capacity_ * 2);
+        }
+    }
+
+public:
+    FlatHashMap() = default;
+    explicit FlatHashMap(size_t initialSize) { reserve(initialSize); }
+
+    FlatHashMap(const FlatHashMap& other) : hasher_(other.hasher_), equal_(other.equal_) {
+        reserve(other.size_);
+        other.forEach([this](const Key& k, const Value& v) { insert(k, v); });
+    }
+    FlatHashMap(FlatHashMap&& other) noexcept { swap(other); }
+    FlatHashMap& operator=(FlatHashMap other) noexcept {
+        swap(other);
+        return *this;
+    }
+    ~FlatHashMap() {
+        destroyAll();
+        deallocate();
+    }
+
+    void swap(FlatHashMap& other) noexcept {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growth_left_, other.growth_left_);
+        std::swap(hasher_, other.hasher_);
+        std::swap(equal_, other.equal_);
+    }
+
+    // 保证放得下 n 个元素不再扩容
+    void reserve(size_t n) {
+        size_t capacity = kGroupWidth;
+        while (maxLoad(capacity) < n) capacity *= 2;
+        if (capacity > capacity_) resize(capacity);
+    }
+
+    // 已存在则覆盖 value 返回 false；新插入返回 true
+    bool insert(const Key& key, const Value& value) {
+        size_t hash = hashOf(key);
+        size_t i = findIndex(key, hash);
+        if (i < capacity_) {
+            slots_[i].value = value;
+            return false;
+        }
+        if (growth_left_ == 0) growOrCleanup();
+        i = findFreeSlot(hash);
+        // 复用墓碑不消耗 growth_left_
+        if (ctrl_[i] == kEmpty) growth_left_--;
+        new (slots_ + i) Slot(key, value);
+        ctrl_[i] = h2(hash);
+        size_++;
+        return true;
+    }
+
+    Value* find(const Key& key) {
+        size_t i = findIndex(key, hashOf(key));
+        return i < capacity_ ? &slots_[i].value : nullptr;
+    }
+    const Value* find(const Key& key) const {
+        size_t i = findIndex(key, hashOf(key));
+        return i < capacity_ ? &slots_[i].value : nullptr;
+    }
+    bool contains(const Key& key) const { return find(key) != nullptr; }
+
+    bool erase(const Key& key) {
+        size_t i = findIndex(key, hashOf(key));
+        if (i >= capacity_) return false;
+        slots_[i].~Slot();
+        size_--;
+        // 本组还有空槽：任何探测序列到这组都已经停下 不会经过这里去找后面的组 直接置空即可
+        size_t groupStart = i & ~(kGroupWidth - 1);
+        if (Group(ctrl_ + groupStart).matchEmpty()) {
+            ctrl_[i] = kEmpty;
+            growth_left_++;
+        } else {
+            ctrl_[i] = kDeleted;
+        }
+        return true;
+    }
+
+    void clear() {
+        destroyAll();
+        if (capacity_) std::memset(ctrl_, static_cast<unsigned char>(kEmpty), capacity_);
+        growth_left_ = maxLoad(capacity_);
+    }
+
+    template <typename F>
+    void forEach(F&& f) const {
+        for (size_t i = 0; i < capacity_; i++) {
+            if (ctrl_[i] >= 0) f(slots_[i].key, slots_[i].value);
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+
+    void printStats() const {
+        size_t tombstones = 0;
+        for (size_t i = 0; i < capacity_; i++) tombstones += ctrl_[i] == kDeleted;
+        // 平均探测组数：每个元素从 H1 起点走到所在组经过了几组 1 表示第一组就命中
+        size_t probes = 0;
+        for (size_t i = 0; i < capacity_; i++) {
+            if (ctrl_[i] < 0) continue;
+            size_t mask = groupMask();
+            size_t pos = h1(hashOf(slots_[i].key)) & mask;
+            size_t target = i & ~(kGroupWidth - 1);
+            for (size_t step = kGroupWidth; pos != target; step += kGroupWidth) {
+                pos = (pos + step) & mask;
+                probes++;
+            }
+            probes++;
+        }
+        std::cout << "Capacity: " << capacity_ << "\n";
+        std::cout << "Elements: " << size_ << "\n";
+        std::cout << "Load Factor: " << (capacity_ ? static_cast<double>(size_) / capacity_ : 0.0) << "\n";
+        std::cout << "Tombstones: " << tombstones << "\n";
+        std::cout << "Avg Groups Probed: " << (size_ ? static_cast<double>(probes) / size_ : 0.0) << "\n";
+    }
+};
@@ -1,99 +1,12 @@
-#include <iostream>
-#include <string>
-#include <vector>
-#include <list>
-#include <functional>
+#include <atomic>
 #include <cassert>
+#include <string_view>
+#include <thread>
 
-
-template <typename Key, typename Value>
-class HashTable {
-private:
-    struct KeyValuePair{
-        Key key;
-        Value value;
-        KeyValuePair(const Key& k, const Value& v) : key(k), value(v) {}
-    };
-    using Bucket = std::list<KeyValuePair>;
-    std::vector<Bucket> buckets;
-    size_t count = 0;//所有元素计数
-    double maxLoaderFactor = 0.75;  //最大负载因子
-
-    size_t hashFunction(const Key& key) const {
-        return std::hash<Key>{}(key) % buckets.size(); //std::hash<Key<{}相当于创建匿名对象
-    }
-
-    void rehash() {
-        std::vector<Bucket> newBuckets(buckets.size() * 2);
-        for(auto& bucket : buckets) {
-            for(auto & kv : bucket){
-                size_t index = std::hash<Key>{}(kv.key) % newBuckets.size();
-                newBuckets[index].push_back(kv);
-            }
-        }
-        buckets = std::move(newBuckets); // 关键修复：移动新桶到成员变量
-    }
-public:
-    HashTable(size_t initialSize = 16) : buckets(initialSize) {}
-    //! 对于相同的键，哈希函数总是返回相同的桶索引​​
-    //! 确定性映射​​：同一个键不可能出现在不同的桶中
-    void insert(const Key& key, const Value& value) {
-        if(static_cast<double>(count + 1) / buckets.size() > maxLoaderFactor) {
-            rehash();
-            std::cout << "running rehash" << std::endl;
-        }
-        size_t index = hashFunction(key);
-        for(auto& kv : buckets[index]){
-            if(kv.key == key){
-                kv.value = value;
-                return;
-            }
-        }
-        buckets[index].emplace_back(key, value);
-        count ++;
-    }
-
-    //这里返回Value* 不返回Value是因为避免拷贝；不返回整个kv是为了安全不让用户根据key修改value
-    Value* find(const Key& key) {
-        size_t index = hashFunction(key);
-        for(auto& kv : buckets[index]){
-            if(kv.key == key){
-                return &kv.value;
-            }
-        }
-        return nullptr;
-    }
-
-    bool erase(const Key& key) {
-        size_t index = hashFunction(key);
-        for(auto it = buckets[index].begin(); it!= buckets[index].end(); ++ it){
-            if(it->key == key){
-                buckets[index].erase(it);
-                count --;
-                return true;
-            }
-        }
-        return false;
-    }
-
-    void printStats() const {
-        std::cout << "Buckets: " << buckets.size() << "\n";
-        std::cout << "Elements: " << count << "\n";
-        std::cout << "Load Factor: " << static_cast<double>(count) / buckets.size() << "\n";
-        
-        size_t maxChain = 0;
-        size_t emptyBuckets = 0;
-        for (const auto& bucket : buckets) {
-            if (bucket.empty()) emptyBuckets++;
-            if (bucket.size() > maxChain) maxChain = bucket.size();
-        }
-        
-        std::cout << "Longest Chain: " << maxChain << "\n";
-        std::cout << "Empty Buckets: " << emptyBuckets << "\n";
-    }
-
-
-};
+#include "hashmap.hpp"
+#include "flat_hashmap.hpp"
+#include "concurrent_hashmap.hpp"
+#include "wyhash.hpp"
 
 void testHashMap() {
     std::cout << "===== 开始HashMap测试 =====" << std::endl;
@@ -224,10 +137,206 @@ void testHashMap() {
         std::cout << "测试7通过: 字符串键测试" << std::endl;
     }
     
+    // 测试8: 渐进式 rehash 迁移过程中插入 / 查找 / 更新 / 删除都要同时看到新旧两张表
+    {
+        HashTable<int, int> ht(4, 1); // 每次操作只迁移 1 个桶 迁移会持续很多次操作
+        const int N = 100000;
+        for (int i = 0; i < N; i++) {
+            ht.insert(i, i);
+            assert(ht.find(i / 2) != nullptr && *ht.find(i / 2) == i / 2);
+        }
+        for (int i = 0; i < N; i += 3) ht.insert(i, -i);
+        for (int i = 0; i < N; i += 2) assert(ht.erase(i) == true);
+        assert(ht.size() == static_cast<size_t>(N / 2));
+        for (int i = 0; i < N; i++) {
+            int* v = ht.find(i);
+            if (i % 2 == 0) {
+                assert(v == nullptr);
+            } else {
+                assert(v != nullptr && *v == (i % 3 == 0 ? -i : i));
+            }
+        }
+        std::cout << "测试8通过: 渐进式 rehash (N=" << N << ")" << std::endl;
+        ht.printStats();
+    }
+
+    // 测试9: 透明哈希 + 移动语义 + 预计算哈希
+    {
+        HashTable<std::string, std::string, WyHash, std::equal_to<>> ht;
+        std::string key = "a key long enough to skip SSO";
+        std::string value = "value";
+        ht.insert(std::move(key), std::move(value));
+        assert(key.empty() && value.empty()); // 新键值都被移动进节点
+
+        std::string_view sv = "a key long enough to skip SSO";
+        assert(ht.find(sv) != nullptr && *ht.find(sv) == "value");
+        assert(ht.find("a key long enough to skip SSO") != nullptr);
+        assert(ht.find(std::string_view("missing")) == nullptr);
+
+        // try_emplace 命中时不动参数 未命中时才用 string_view 构造 std::string
+        std::string other = "other";
+        auto r1 = ht.try_emplace(sv, std::move(other));
+        assert(!r1.second && *r1.first == "value" && other == "other");
+        auto r2 = ht.try_emplace(std::string_view("new"), std::move(other));
+        assert(r2.second && *r2.first == "other" && other.empty());
+
+        auto r3 = ht.emplace(std::string(3, 'x'), "xxx");
+        assert(r3.second && *ht.find("xxx") == "xxx");
+        assert(!ht.emplace("xxx", "yyy").second);
+
+        size_t h = ht.hash(sv);
+        assert(h == WyHash{}(std::string("a key long enough to skip SSO")));
+        assert(ht.find(sv, h) != nullptr);
+        assert(ht.erase(sv, h) == true);
+        assert(ht.find(sv) == nullptr);
+        assert(ht.size() == 2);
+        std::cout << "测试9通过: 异构查找 移动插入 预计算哈希" << std::endl;
+    }
+
+    std::cout << "===== 所有测试通过! =====" << std::endl;
+}
+
+struct CopyCounter {
+    static int copies;
+    int v = 0;
+    CopyCounter(int x) : v(x) {}
+    CopyCounter(const CopyCounter& o) : v(o.v) { copies++; }
+    CopyCounter(CopyCounter&&) = default;
+    CopyCounter& operator=(const CopyCounter& o) { v = o.v; copies++; return *this; }
+    CopyCounter& operator=(CopyCounter&&) = default;
+};
+int CopyCounter::copies = 0;
+
+void testFlatHashMap() {
+    std::cout << "===== 开始FlatHashMap测试 =====" << std::endl;
+
+    // 测试1: 插入 / 覆盖 / 删除 与 HashTable 行为一致
+    {
+        FlatHashMap<std::string, int> ht;
+        assert(ht.insert("apple", 10) == true);
+        assert(ht.insert("banana", 20) == true);
+        assert(ht.insert("apple", 15) == false);
+        assert(*ht.find("apple") == 15);
+        assert(ht.find("grape") == nullptr);
+        assert(ht.erase("apple") == true);
+        assert(ht.erase("apple") == false);
+        assert(ht.find("apple") == nullptr);
+        assert(ht.size() == 1);
+        std::cout << "测试1通过: 插入 覆盖 删除" << std::endl;
+    }
+
+    // 测试2: 多次扩容后数据完整 且扩容时值是移动过去的: 拷贝次数应该正好等于插入次数
+    {
+        FlatHashMap<int, CopyCounter> ht;
+        const int N = 100000;
+        CopyCounter::copies = 0;
+        for (int i = 0; i < N; i++) ht.insert(i, CopyCounter{i * 10});
+        for (int i = 0; i < N; i++) {
+            assert(ht.find(i) != nullptr && ht.find(i)->v == i * 10);
+        }
+        assert(ht.size() == static_cast<size_t>(N));
+        assert(CopyCounter::copies == N);
+        std::cout << "测试2通过: 扩容 (N=" << N << ", capacity=" << ht.capacity() << ")" << std::endl;
+    }
+
+    // 测试3: 反复插入删除产生大量墓碑 容量不应无限增长
+    {
+        FlatHashMap<int, int> ht;
+        for (int i = 0; i < 1000; i++) ht.insert(i, i);
+        size_t capacity = ht.capacity();
+        for (int round = 0; round < 100; round++) {
+            for (int i = 0; i < 1000; i++) assert(ht.erase(round * 1000 + i));
+            for (int i = 0; i < 1000; i++) ht.insert((round + 1) * 1000 + i, i);
+        }
+        assert(ht.size() == 1000);
+        assert(ht.capacity() == capacity);
+        for (int i = 0; i < 1000; i++) assert(*ht.find(100 * 1000 + i) == i);
+        std::cout << "测试3通过: 墓碑回收 容量保持 " << capacity << std::endl;
+        ht.printStats();
+    }
+
+    // 测试4: 拷贝与移动
+    {
+        FlatHashMap<std::string, std::string> a;
+        a.insert("name", "Alice");
+        a.insert("city", "New York");
+        FlatHashMap<std::string, std::string> b = a;
+        b.insert("name", "Bob");
+        assert(*a.find("name") == "Alice");
+        assert(*b.find("name") == "Bob");
+        FlatHashMap<std::string, std::string> c = std::move(b);
+        assert(*c.find("city") == "New York");
+        assert(b.size() == 0 && b.find("city") == nullptr);
+        std::cout << "测试4通过: 拷贝与移动" << std::endl;
+    }
+
+    std::cout << "===== 所有测试通过! =====" << std::endl;
+}
+
+void testConcurrentHashMap() {
+    std::cout << "===== 开始ConcurrentHashMap测试 =====" << std::endl;
+    const int kThreads = 4;
+    const int N = 20000;
+
+    // 测试1: 各线程写不相交的键区间 再删掉一半
+    {
+        ConcurrentHashMap<int, int> m(8);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&m, t] {
+                for (int i = t * N; i < (t + 1) * N; i++) assert(m.insert_or_assign(i, i));
+                for (int i = t * N; i < (t + 1) * N; i += 2) assert(m.erase(i));
+            });
+        }
+        for (auto& th : threads) th.join();
+        assert(m.size() == static_cast<size_t>(kThreads * N / 2));
+        for (int i = 0; i < kThreads * N; i++) {
+            auto v = m.find(i);
+            assert(v.has_value() == (i % 2 == 1));
+            if (v) assert(*v == i);
+        }
+        std::cout << "测试1通过: 并发插入删除" << std::endl;
+    }
+
+    // 测试2: 所有线程对同一批键 compute_if_absent 每个键的 f 只执行一次
+    {
+        ConcurrentHashMap<int, int> m(8);
+        std::atomic<int> calls{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < N; i++) {
+                    int v = m.compute_if_absent(i, [&] {
+                        calls++;
+                        return i * 3;
+                    });
+                    assert(v == i * 3);
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        assert(calls == N);
+        std::cout << "测试2通过: compute_if_absent 只计算一次" << std::endl;
+    }
+
+    // 测试3: 透明哈希下用 string_view 查找 / 删除 / compute_if_absent
+    {
+        ConcurrentHashMap<std::string, int, WyHash, std::equal_to<>> m(4);
+        m.insert_or_assign(std::string("alpha"), 1);
+        std::string_view sv = "alpha";
+        assert(m.find(sv).value() == 1);
+        assert(m.compute_if_absent(std::string_view("beta"), [] { return 2; }) == 2);
+        assert(m.find("beta").value() == 2);
+        assert(m.erase(sv) && !m.contains(sv));
+        std::cout << "测试3通过: 异构键" << std::endl;
+    }
+
     std::cout << "===== 所有测试通过! =====" << std::endl;
 }
 
 int main() {
     testHashMap();
+    testFlatHashMap();
+    testConcurrentHashMap();
     return 0;
 }
\ No newline at end of file
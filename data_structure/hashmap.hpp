@@ -0,0 +1,326 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace hashmap_detail {
+// 异构查找的参数类型：Hash 和 KeyEqual 都声明了 is_transparent 时 find/erase/try_emplace 接受任意类型 K
+// 否则就是 const Key& (和原来一样 传 const char* 会先构造一个临时 Key)
+// 用别名模板而不是 std::conditional_t：透明时它就是 K 本身 仍然能从实参推导出来
+template <bool Transparent>
+struct KeyArg {
+    template <typename K, typename KeyType>
+    using type = KeyType;
+};
+template <>
+struct KeyArg<true> {
+    template <typename K, typename KeyType>
+    using type = K;
+};
+
+template <typename T, typename = void>
+struct IsTransparent : std::false_type {};
+template <typename T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+}  // namespace hashmap_detail
+
+/**
+ * Hash / KeyEqual 可替换：字符串键推荐 HashTable<std::string, V, WyHash, std::equal_to<>> (wyhash.hpp)
+ * 这样 find / erase / try_emplace 可以直接传 std::string_view 或 const char* 不分配临时字符串
+ * 带 size_t hash 参数的重载用调用方预先算好的哈希(必须等于 hash(key))：同一个键要查多次、或先用哈希选分片时只算一次
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class HashTable {
+private:
+    struct KeyValuePair{
+        size_t hash;    // 缓存的完整哈希值：rehash 不用重算(字符串键很贵) 链上先比哈希再比键
+        Key key;
+        Value value;
+        template <typename K, typename... Args>
+        KeyValuePair(size_t h, K&& k, Args&&... args)
+            : hash(h), key(std::forward<K>(k)), value(std::forward<Args>(args)...) {}
+    };
+    static constexpr bool kTransparent =
+        hashmap_detail::IsTransparent<Hash>::value && hashmap_detail::IsTransparent<KeyEqual>::value;
+    template <typename K>
+    using key_arg = typename hashmap_detail::KeyArg<kTransparent>::template type<K, Key>;
+
+    using Bucket = std::list<KeyValuePair>;
+    using BucketIter = typename Bucket::iterator;
+    std::vector<Bucket> buckets;
+    size_t count = 0;//所有元素计数(迁移期间包括新旧两张表)
+    double maxLoaderFactor = 0.75;  //最大负载因子
+
+    //! 渐进式 rehash (Redis dict 的做法)：扩容时不一次搬完 新旧两张表并存
+    //! 之后每次 insert/find/erase 顺带从旧表迁移最多 rehashStep 个非空桶 单次操作的代价有上界
+    //! 迁移期间新元素只进新表；查找先查新表 再查旧表里还没迁走的桶
+    //! 旧表从尾部往前迁 迁完一个就 pop_back 析构 迁移结束时不用再一次析构几百万个空链表
+    size_t rehashStep = 0;          // 0 表示同步 rehash
+    std::vector<Bucket> oldBuckets; // 迁移中的旧表 下标 < size() 的桶还没迁移
+    size_t oldBucketCount = 0;      // 旧表原本的桶数 算旧表下标用 不在迁移时为 0
+    //! 新表本身(2 倍个空链表)一次构造完也要几百毫秒 大部分是缺页
+    //! 所以渐进模式下负载过半就 reserve 好下一张表 之后每 kPrepareEvery 次 insert 构造一批桶
+    //! 平均每次 insert 摊到 16 个桶；攒成一批做是为了让缺页集中在极少数操作上 不污染 p99/p99.9
+    static constexpr size_t kPrepareEvery = 4096;
+    static constexpr size_t kPrepareStep = kPrepareEvery * 16;
+    size_t prepareTick = 0;
+    std::vector<Bucket> nextBuckets;
+    Hash hasher;
+    KeyEqual equal;
+
+    bool rehashing() const { return oldBucketCount > 0; }
+
+    // splice 直接把链表节点挂到新桶 不拷贝也不重新分配节点
+    void moveBucket(Bucket& bucket) {
+        while(!bucket.empty()){
+            size_t index = bucket.front().hash % buckets.size();
+            buckets[index].splice(buckets[index].end(), bucket, bucket.begin());
+        }
+    }
+
+    void prepareNext(size_t n) {
+        size_t target = buckets.size() * 2;
+        if(nextBuckets.capacity() < target) {
+            nextBuckets.clear();
+            nextBuckets.reserve(target);
+        }
+        while(n-- > 0 && nextBuckets.size() < target) nextBuckets.emplace_back();
+    }
+
+    void rehash() {
+        std::vector<Bucket> newBuckets;
+        if(rehashStep > 0) {
+            prepareNext(buckets.size() * 2); // 通常已经构造完了 这里只是兜底
+            newBuckets = std::move(nextBuckets);
+            nextBuckets = std::vector<Bucket>();
+        } else {
+            newBuckets.resize(buckets.size() * 2);
+        }
+        std::swap(buckets, newBuckets);
+        if(rehashStep == 0) {
+            for(auto& bucket : newBuckets) moveBucket(bucket);
+            return;
+        }
+        oldBuckets = std::move(newBuckets);
+        oldBucketCount = oldBuckets.size();
+    }
+
+    // 迁移最多 n 个非空桶；空桶也要跳过 同样限制在 n * 10 个以内 防止稀疏的旧表让一次调用扫很久
+    void migrate(size_t n) {
+        size_t emptyVisits = n * 10;
+        while(n > 0 && !oldBuckets.empty()) {
+            bool empty = oldBuckets.back().empty();
+            moveBucket(oldBuckets.back());
+            oldBuckets.pop_back();
+            if(empty) {
+                if(--emptyVisits == 0) break;
+                continue;
+            }
+            n--;
+        }
+        if(oldBuckets.empty()) {
+            std::vector<Bucket>().swap(oldBuckets); // 释放旧表内存
+            oldBucketCount = 0;
+        }
+    }
+
+    void rehashStepOnce() {
+        if(rehashing()) migrate(rehashStep);
+    }
+
+    // 找到 key 时 bucket/pos 指向它所在的链表节点(可能在旧表)
+    template <typename K>
+    bool locate(const K& key, size_t hash, Bucket*& bucket, BucketIter& pos) {
+        Bucket* b = &buckets[hash % buckets.size()];
+        for(auto it = b->begin(); it != b->end(); ++ it){
+            if(it->hash == hash && equal(it->key, key)){
+                bucket = b;
+                pos = it;
+                return true;
+            }
+        }
+        if(rehashing()) {
+            size_t oldIndex = hash % oldBucketCount;
+            if(oldIndex < oldBuckets.size()) {
+                Bucket* ob = &oldBuckets[oldIndex];
+                for(auto it = ob->begin(); it != ob->end(); ++ it){
+                    if(it->hash == hash && equal(it->key, key)){
+                        bucket = ob;
+                        pos = it;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // 插入新键之前：推进下一张表的预构造 负载超限时扩容
+    void growIfNeeded() {
+        if(rehashStep > 0 && !rehashing() && static_cast<double>(count) / buckets.size() > maxLoaderFactor / 2) {
+            if(++prepareTick % kPrepareEvery == 0) prepareNext(kPrepareStep);
+        }
+        if(static_cast<double>(count + 1) / buckets.size() > maxLoaderFactor) {
+            // 上一轮迁移还没结束又要扩容(只在 rehashStep 很小、插入极快时出现) 先把它做完
+            if(rehashing()) migrate(oldBucketCount);
+            rehash();
+        }
+    }
+
+    // 调用方已确认 key 不存在：直接在新表的桶里原地构造节点
+    template <typename K, typename... Args>
+    Value* emplaceNew(size_t hash, K&& key, Args&&... args) {
+        growIfNeeded();
+        Bucket& bucket = buckets[hash % buckets.size()];
+        bucket.emplace_back(hash, std::forward<K>(key), std::forward<Args>(args)...);
+        count ++;
+        return &bucket.back().value;
+    }
+
+    template <typename K, typename V>
+    void insertOrAssign(K&& key, V&& value, size_t hash) {
+        rehashStepOnce();
+        Bucket* bucket;
+        BucketIter pos;
+        if(locate(key, hash, bucket, pos)) {
+            pos->value = std::forward<V>(value);
+            return;
+        }
+        emplaceNew(hash, std::forward<K>(key), std::forward<V>(value));
+    }
+
+    // 值只在键不存在时才构造
+    template <typename K, typename... Args>
+    std::pair<Value*, bool> tryEmplace(size_t hash, K&& key, Args&&... args) {
+        rehashStepOnce();
+        Bucket* bucket;
+        BucketIter pos;
+        if(locate(key, hash, bucket, pos)) return {&pos->value, false};
+        return {emplaceNew(hash, std::forward<K>(key), std::forward<Args>(args)...), true};
+    }
+public:
+    // incrementalStep > 0 时启用渐进式 rehash 每次操作最多迁移这么多个非空桶
+    HashTable(size_t initialSize = 16, size_t incrementalStep = 0, const Hash& hash = Hash(),
+              const KeyEqual& keyEqual = KeyEqual())
+        : buckets(initialSize), rehashStep(incrementalStep), hasher(hash), equal(keyEqual) {}
+
+    template <typename K = Key>
+    size_t hash(const key_arg<K>& key) const { return hasher(key); }
+
+    //! 对于相同的键，哈希函数总是返回相同的桶索引​​
+    //! 确定性映射​​：同一个键不可能出现在不同的桶中
+    void insert(const Key& key, const Value& value) { insertOrAssign(key, value, hasher(key)); }
+    // 右值版本：新键直接移动进节点 已存在时移动赋值 value
+    void insert(Key&& key, Value&& value) {
+        size_t h = hasher(key);
+        insertOrAssign(std::move(key), std::move(value), h);
+    }
+    void insert(const Key& key, const Value& value, size_t hash) { insertOrAssign(key, value, hash); }
+    void insert(Key&& key, Value&& value, size_t hash) { insertOrAssign(std::move(key), std::move(value), hash); }
+
+    // 键不存在时用 args 构造值插入 返回 {值, true}；已存在时什么都不做(args 不会被移走) 返回 {已有值, false}
+    // 透明哈希下 key 可以是 string_view 等 只在真正插入时才构造 Key
+    template <typename K = Key, typename... Args>
+    std::pair<Value*, bool> try_emplace(key_arg<K>&& key, Args&&... args) {
+        size_t h = hasher(key);
+        return tryEmplace(h, std::forward<key_arg<K>>(key), std::forward<Args>(args)...);
+    }
+    template <typename K = Key, typename... Args>
+    std::pair<Value*, bool> try_emplace(const key_arg<K>& key, Args&&... args) {
+        return tryEmplace(hasher(key), key, std::forward<Args>(args)...);
+    }
+
+    // 先用 key/value 构造出节点再查重：键需要从参数现场构造时用 已存在则丢弃新节点
+    // 查重后节点是 splice 进桶的 不会分配第二次
+    template <typename K, typename V>
+    std::pair<Value*, bool> emplace(K&& key, V&& value) {
+        Bucket node;
+        node.emplace_back(0, std::forward<K>(key), std::forward<V>(value));
+        KeyValuePair& kv = node.front();
+        kv.hash = hasher(kv.key);
+        rehashStepOnce();
+        Bucket* bucket;
+        BucketIter pos;
+        if(locate(kv.key, kv.hash, bucket, pos)) return {&pos->value, false};
+        growIfNeeded();
+        Bucket& target = buckets[kv.hash % buckets.size()];
+        target.splice(target.end(), node);
+        count ++;
+        return {&target.back().value, true};
+    }
+
+    //这里返回Value* 不返回Value是因为避免拷贝；不返回整个kv是为了安全不让用户根据key修改value
+    template <typename K = Key>
+    Value* find(const key_arg<K>& key) { return find<K>(key, hasher(key)); }
+
+    template <typename K = Key>
+    Value* find(const key_arg<K>& key, size_t hash) {
+        rehashStepOnce();
+        Bucket* bucket;
+        BucketIter pos;
+        return locate(key, hash, bucket, pos) ? &pos->value : nullptr;
+    }
+
+    // 只读查找：不推进渐进式 rehash 不修改任何状态 多个线程持读锁同时调用是安全的
+    template <typename K = Key>
+    const Value* find(const key_arg<K>& key) const { return find<K>(key, hasher(key)); }
+
+    template <typename K = Key>
+    const Value* find(const key_arg<K>& key, size_t hash) const {
+        for(auto& kv : buckets[hash % buckets.size()]){
+            if(kv.hash == hash && equal(kv.key, key)) return &kv.value;
+        }
+        if(rehashing()) {
+            size_t oldIndex = hash % oldBucketCount;
+            if(oldIndex < oldBuckets.size()) {
+                for(auto& kv : oldBuckets[oldIndex]){
+                    if(kv.hash == hash && equal(kv.key, key)) return &kv.value;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename K = Key>
+    bool erase(const key_arg<K>& key) { return erase<K>(key, hasher(key)); }
+
+    template <typename K = Key>
+    bool erase(const key_arg<K>& key, size_t hash) {
+        rehashStepOnce();
+        Bucket* bucket;
+        BucketIter pos;
+        if(!locate(key, hash, bucket, pos)) return false;
+        bucket->erase(pos);
+        count --;
+        return true;
+    }
+
+    size_t size() const { return count; }
+
+    void printStats() const {
+        std::cout << "Buckets: " << buckets.size() << "\n";
+        if (rehashing()) {
+            std::cout << "Rehashing: " << oldBucketCount - oldBuckets.size() << "/" << oldBucketCount
+                      << " old buckets migrated\n";
+        }
+        std::cout << "Elements: " << count << "\n";
+        std::cout << "Load Factor: " << static_cast<double>(count) / buckets.size() << "\n";
+        
+        size_t maxChain = 0;
+        size_t emptyBuckets = 0;
+        for (const auto& bucket : buckets) {
+            if (bucket.empty()) emptyBuckets++;
+            if (bucket.size() > maxChain) maxChain = bucket.size();
+        }
+        
+        std::cout << "Longest Chain: " << maxChain << "\n";
+        std::cout << "Empty Buckets: " << emptyBuckets << "\n";
+    }
+
+
+};
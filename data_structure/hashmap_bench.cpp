@@ -0,0 +1,184 @@
+// 哈希表基准：链式 HashTable vs std::unordered_map vs 开放寻址 FlatHashMap
+// 键是随机 uint64 值是 uint64 规模从 1K 到 10M 每项报告每次操作的平均 ns
+//   insert    从空表开始插入 N 个键 (含所有扩容)
+//   find hit  乱序查找全部 N 个已存在的键
+//   find miss 查找 N 个不存在的键
+//   erase     乱序删除全部 N 个键
+// 小规模重复多轮 让每项至少做约 2M 次操作 结果取平均
+//
+// 最后是字符串键的热路径查找：手里是 string_view (比如从请求报文里切出来的) 要查 std::string 键的表
+//   std::hash     只能先构造 std::string 再查 键超过 SSO 长度时每次查找一次 malloc
+//   WyHash 透明   直接用 string_view 查 不分配
+//   预计算哈希     哈希在循环外算好 (同一个键查多张表 / 分片选择时复用)
+// 全局 operator new 计数 报告每次查找的平均分配次数
+//
+// 编译: g++ -std=c++17 -O2 -march=native -o hashmap_bench hashmap_bench.cpp
+// 运行: ./hashmap_bench [最大键数 默认 10000000]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hashmap.hpp"
+#include "flat_hashmap.hpp"
+#include "wyhash.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// 单线程基准 计数不需要原子
+static size_t g_allocs = 0;
+
+void* operator new(size_t n) {
+    g_allocs++;
+    if (void* p = std::malloc(n)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// 三种表的接口统一成 insert / find / erase
+struct StdMap {
+    std::unordered_map<uint64_t, uint64_t> m;
+    void insert(uint64_t k, uint64_t v) { m[k] = v; }
+    uint64_t* find(uint64_t k) {
+        auto it = m.find(k);
+        return it == m.end() ? nullptr : &it->second;
+    }
+    bool erase(uint64_t k) { return m.erase(k) > 0; }
+};
+
+struct Result {
+    double insert = 0, hit = 0, miss = 0, erase = 0;  // 总耗时 ns
+};
+
+static double since(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+template <typename Map>
+Result run(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& lookup,
+           const std::vector<uint64_t>& missing, int rounds) {
+    Result r;
+    uint64_t sum = 0;
+    for (int round = 0; round < rounds; round++) {
+        Map* m = new Map();
+        auto start = Clock::now();
+        for (uint64_t k : keys) m->insert(k, k);
+        r.insert += since(start);
+
+        start = Clock::now();
+        for (uint64_t k : lookup) {
+            uint64_t* v = m->find(k);
+            if (!v) {
+                std::fprintf(stderr, "missing key %llu\n", (unsigned long long)k);
+                std::exit(1);
+            }
+            sum += *v;
+        }
+        r.hit += since(start);
+
+        start = Clock::now();
+        for (uint64_t k : missing) sum += m->find(k) != nullptr;
+        r.miss += since(start);
+
+        start = Clock::now();
+        for (uint64_t k : lookup) sum += m->erase(k);
+        r.erase += since(start);
+        delete m;
+    }
+    if (sum == 42) std::printf("\n");  // 防止查找被优化掉
+    return r;
+}
+
+static void report(const char* name, size_t n, int rounds, const Result& r) {
+    double ops = static_cast<double>(n) * rounds;
+    std::printf("%10zu  %-14s %10.1f %10.1f %10.1f %10.1f\n", n, name, r.insert / ops, r.hit / ops, r.miss / ops,
+                r.erase / ops);
+}
+
+template <typename Lookup>
+static void stringLookup(const char* name, const std::vector<std::string_view>& queries, int rounds, Lookup&& lookup) {
+    size_t hits = 0;
+    size_t allocs = g_allocs;
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < queries.size(); i++) hits += lookup(i);
+    }
+    double ns = since(start);
+    double ops = static_cast<double>(queries.size()) * rounds;
+    std::printf("  %-28s %8.1f ns/op %8.2f allocs/op\n", name, ns / ops, (g_allocs - allocs) / ops);
+    if (hits != queries.size() * rounds) {
+        std::fprintf(stderr, "%s: %zu hits\n", name, hits);
+        std::exit(1);
+    }
+}
+
+// 100K 个 24~40 字节的键 (超过 libstdc++ 的 15 字节 SSO)
+static void benchStringLookup() {
+    const size_t n = 100000;
+    std::mt19937_64 rng(777);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; i++) {
+        std::string k = "session:" + std::to_string(rng()) + ":";
+        k.resize(24 + rng() % 17, 'k');
+        keys.push_back(std::move(k));
+    }
+    // 查询串放在另一块内存 和表里的键不共享存储
+    std::string arena;
+    for (auto& k : keys) arena += k;
+    std::vector<std::string_view> queries;
+    for (size_t i = 0, off = 0; i < n; off += keys[i].size(), i++) queries.emplace_back(arena.data() + off, keys[i].size());
+    std::shuffle(queries.begin(), queries.end(), rng);
+
+    HashTable<std::string, int> plain(n * 2);
+    HashTable<std::string, int, WyHash, std::equal_to<>> wy(n * 2);
+    for (size_t i = 0; i < n; i++) {
+        plain.insert(keys[i], static_cast<int>(i));
+        wy.insert(keys[i], static_cast<int>(i));
+    }
+    std::vector<size_t> hashes;
+    for (auto q : queries) hashes.push_back(wy.hash(q));
+
+    const int rounds = 20;
+    std::printf("\nstring keys: %zu keys of 24..40 bytes, lookups by string_view\n", n);
+    stringLookup("std::hash + std::string(sv)", queries, rounds,
+                 [&](size_t i) { return plain.find(std::string(queries[i])) != nullptr; });
+    stringLookup("WyHash transparent", queries, rounds, [&](size_t i) { return wy.find(queries[i]) != nullptr; });
+    stringLookup("WyHash precomputed hash", queries, rounds,
+                 [&](size_t i) { return wy.find(queries[i], hashes[i]) != nullptr; });
+}
+
+int main(int argc, char* argv[]) {
+    size_t maxN = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    std::mt19937_64 rng(12345);
+
+    std::printf("%10s  %-14s %10s %10s %10s %10s   (ns/op)\n", "keys", "map", "insert", "find hit", "find miss",
+                "erase");
+    for (size_t n = 1000; n <= maxN; n *= 10) {
+        // 最高位区分存在 / 不存在的键 保证 miss 一定不命中
+        std::vector<uint64_t> keys(n), missing(n);
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = rng() & ~(1ull << 63);
+            missing[i] = rng() | (1ull << 63);
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        std::shuffle(keys.begin(), keys.end(), rng);
+        std::vector<uint64_t> lookup = keys;
+        std::shuffle(lookup.begin(), lookup.end(), rng);
+
+        int rounds = static_cast<int>(std::max<size_t>(1, 2000000 / n));
+        report("HashTable", n, rounds, run<HashTable<uint64_t, uint64_t>>(keys, lookup, missing, rounds));
+        report("unordered_map", n, rounds, run<StdMap>(keys, lookup, missing, rounds));
+        report("FlatHashMap", n, rounds, run<FlatHashMap<uint64_t, uint64_t>>(keys, lookup, missing, rounds));
+    }
+    benchStringLookup();
+    return 0;
+}
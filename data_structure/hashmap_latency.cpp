@@ -0,0 +1,68 @@
+// HashTable 单次 insert 的延迟分布：同步 rehash vs 渐进式 rehash
+// 从空表插入 N 个随机键 每次 insert 用 rdtsc 计时 按表的规模(插入序号的数量级)分段统计
+// 同步模式下每次扩容那一次 insert 要搬完整张表 规模越大 max 和 p99.9 越高
+// 渐进模式下每次操作最多迁移 step 个桶 各段的 p99.9 应该基本不随规模变化
+// 剩下的尖刺来自分配新桶数组本身(构造 2 倍个空链表) 只影响 max
+//
+// 编译: g++ -std=c++17 -O2 -o hashmap_latency hashmap_latency.cpp
+// 运行: ./hashmap_latency [键数 默认 10000000] [每次迁移桶数 默认 4]
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "hashmap.hpp"
+#include "../multi-msg-que/latency_histogram.hpp"
+
+static void run(const char* name, size_t n, size_t step, const std::vector<uint64_t>& keys) {
+    HashTable<uint64_t, uint64_t> ht(16, step);
+    std::vector<LatencyHistogram> hists;
+    LatencyHistogram all;
+    double ns = TscClock::ns_per_tick();
+    size_t segEnd = 1000;
+    hists.emplace_back();
+    for (size_t i = 0; i < n; i++) {
+        if (i == segEnd) {
+            hists.emplace_back();
+            segEnd *= 10;
+        }
+        uint64_t t0 = TscClock::now();
+        ht.insert(keys[i], i);
+        uint64_t dt = TscClock::now() - t0;
+        hists.back().record(dt);
+        all.record(dt);
+    }
+
+    std::printf("%s\n", name);
+    std::printf("  %-22s %10s %10s %10s %12s   (ns)\n", "inserts", "p50", "p99", "p99.9", "max");
+    size_t lo = 0, hi = 1000;
+    for (auto& h : hists) {
+        char range[48];
+        std::snprintf(range, sizeof(range), "[%zu, %zu)", lo, hi < n ? hi : n);
+        std::printf("  %-22s %10.0f %10.0f %10.0f %12.0f\n", range, h.percentile(0.5) * ns,
+                    h.percentile(0.99) * ns, h.percentile(0.999) * ns, h.max() * ns);
+        lo = hi;
+        hi *= 10;
+    }
+    std::printf("  %-22s %10.0f %10.0f %10.0f %12.0f\n", "all", all.percentile(0.5) * ns,
+                all.percentile(0.99) * ns, all.percentile(0.999) * ns, all.max() * ns);
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    size_t step = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+    if (step == 0) {
+        std::fprintf(stderr, "step must be positive\n");
+        return 1;
+    }
+    std::mt19937_64 rng(12345);
+    std::vector<uint64_t> keys(n);
+    for (auto& k : keys) k = rng();
+
+    run("synchronous rehash", n, 0, keys);
+    char name[64];
+    std::snprintf(name, sizeof(name), "incremental rehash (step=%zu)", step);
+    run(name, n, step, keys);
+    return 0;
+}
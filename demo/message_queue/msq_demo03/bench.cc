@@ -0,0 +1,222 @@
+// 三种本机 IPC 传输对比：SysV msgsnd / POSIX mq_send / 共享内存环形队列
+// 吞吐：子进程连续发送 父进程接收 统计 msgs/s
+// 延迟：父子进程 ping-pong 统计往返时间 p50 / p99
+//
+// 编译: make bench
+// 运行: ./bench [消息条数] [消息字节数]
+#include "shm_ring.hpp"
+#include <algorithm>
+#include <vector>
+#include <ctime>
+#include <mqueue.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/wait.h>
+
+// dir 0: 父 -> 子   dir 1: 子 -> 父
+struct Transport
+{
+    const char *name;
+    void (*setup)();
+    void (*teardown)();
+    void (*send)(int dir, const void *buf, size_t len);
+    ssize_t (*recv)(int dir, void *buf, size_t cap);
+};
+
+// ---------------------- SysV 消息队列 ----------------------
+static int sysv_id;
+
+struct SysvMsg
+{
+    long mtype;
+    char mtext[BUFF_SIZE];
+};
+
+static void sysv_setup()
+{
+    sysv_id = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    if (sysv_id < 0)
+    {
+        perror("msgget");
+        exit(1);
+    }
+}
+
+static void sysv_teardown() { msgctl(sysv_id, IPC_RMID, nullptr); }
+
+static void sysv_send(int dir, const void *buf, size_t len)
+{
+    SysvMsg m;
+    m.mtype = dir + 1;
+    memcpy(m.mtext, buf, len);
+    while (msgsnd(sysv_id, &m, len, 0) < 0 && errno == EINTR)
+        ;
+}
+
+static ssize_t sysv_recv(int dir, void *buf, size_t cap)
+{
+    SysvMsg m;
+    ssize_t n = msgrcv(sysv_id, &m, BUFF_SIZE, dir + 1, 0);
+    if (n > 0)
+        memcpy(buf, m.mtext, std::min<size_t>(n, cap));
+    return n;
+}
+
+// ---------------------- POSIX 消息队列 ----------------------
+static const char *const POSIX_NAMES[2] = {"/bench_mq_a", "/bench_mq_b"};
+static mqd_t posix_q[2];
+
+static void posix_setup()
+{
+    struct mq_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.mq_maxmsg = 10;    // 默认 /proc/sys/fs/mqueue/msg_max 上限
+    attr.mq_msgsize = BUFF_SIZE;
+    for (int i = 0; i < 2; i++)
+    {
+        mq_unlink(POSIX_NAMES[i]);
+        posix_q[i] = mq_open(POSIX_NAMES[i], O_CREAT | O_RDWR, 0600, &attr);
+        if (posix_q[i] == (mqd_t)-1)
+        {
+            perror("mq_open");
+            exit(1);
+        }
+    }
+}
+
+static void posix_teardown()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        mq_close(posix_q[i]);
+        mq_unlink(POSIX_NAMES[i]);
+    }
+}
+
+static void posix_send(int dir, const void *buf, size_t len)
+{
+    mq_send(posix_q[dir], static_cast<const char *>(buf), len, 0);
+}
+
+static ssize_t posix_recv(int dir, void *buf, size_t cap)
+{
+    char tmp[BUFF_SIZE];
+    ssize_t n = mq_receive(posix_q[dir], tmp, BUFF_SIZE, nullptr);
+    if (n > 0)
+        memcpy(buf, tmp, std::min<size_t>(n, cap));
+    return n;
+}
+
+// ---------------------- 共享内存环形队列 ----------------------
+static const char *const RING_NAMES[2] = {"/bench_ring_a", "/bench_ring_b"};
+static ShmRing *rings[2];
+
+static void shm_setup()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        shm_unlink(RING_NAMES[i]);
+        rings[i] = CreateRing(RING_NAMES[i]);
+    }
+}
+
+static void shm_teardown()
+{
+    for (int i = 0; i < 2; i++)
+        DeleteRing(rings[i], RING_NAMES[i]);
+}
+
+static void shm_send(int dir, const void *buf, size_t len) { RingSend(rings[dir], buf, len); }
+
+static ssize_t shm_recv(int dir, void *buf, size_t cap) { return RingRecv(rings[dir], buf, cap); }
+
+// ---------------------- 测试 ----------------------
+static long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static double throughput(const Transport &t, int count, size_t size)
+{
+    char buf[BUFF_SIZE];
+    memset(buf, 'x', sizeof(buf));
+    long long start = now_ns();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        for (int i = 0; i < count; i++)
+            t.send(1, buf, size);
+        _exit(0);
+    }
+    for (int i = 0; i < count; i++)
+        t.recv(1, buf, sizeof(buf));
+    long long end = now_ns();
+    waitpid(pid, nullptr, 0);
+    return count * 1e9 / (end - start);
+}
+
+static void latency(const Transport &t, int count, size_t size, long long *p50, long long *p99)
+{
+    char buf[BUFF_SIZE];
+    memset(buf, 'x', sizeof(buf));
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            ssize_t n = t.recv(0, buf, sizeof(buf));
+            if (n < 0)
+            {
+                perror("recv");
+                _exit(1);
+            }
+            t.send(1, buf, n);
+        }
+        _exit(0);
+    }
+    std::vector<long long> rtt(count);
+    for (int i = 0; i < count; i++)
+    {
+        long long start = now_ns();
+        t.send(0, buf, size);
+        if (t.recv(1, buf, sizeof(buf)) < 0)
+        {
+            perror("recv");
+            exit(1);
+        }
+        rtt[i] = now_ns() - start;
+    }
+    waitpid(pid, nullptr, 0);
+    std::sort(rtt.begin(), rtt.end());
+    *p50 = rtt[count / 2];
+    *p99 = rtt[count * 99 / 100];
+}
+
+int main(int argc, char *argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    size_t size = argc > 2 ? strtoul(argv[2], nullptr, 10) : 64;
+    if (size == 0 || size > BUFF_SIZE)
+        size = BUFF_SIZE;
+
+    const Transport transports[] = {
+        {"sysv msgsnd", sysv_setup, sysv_teardown, sysv_send, sysv_recv},
+        {"posix mq_send", posix_setup, posix_teardown, posix_send, posix_recv},
+        {"shm ring", shm_setup, shm_teardown, shm_send, shm_recv},
+    };
+
+    printf("messages=%d size=%zu bytes\n", count, size);
+    printf("%-16s %14s %14s %14s\n", "transport", "msgs/s", "rtt p50 ns", "rtt p99 ns");
+    for (const Transport &t : transports)
+    {
+        t.setup();
+        double rate = throughput(t, count, size);
+        long long p50, p99;
+        latency(t, count / 10 > 0 ? count / 10 : 1, size, &p50, &p99);
+        t.teardown();
+        printf("%-16s %14.0f %14lld %14lld\n", t.name, rate, p50, p99);
+    }
+    return 0;
+}
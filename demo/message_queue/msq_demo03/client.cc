@@ -0,0 +1,16 @@
+#include "shm_ring.hpp"
+
+int main()
+{
+    ShmRing *ring = GetRing();
+    while (true)
+    {
+        std::cout << "Says # ";
+        std::string s;
+        if (!std::getline(std::cin, s))
+            break;
+        if (RingSend(ring, s.c_str(), s.size()) < 0)
+            perror("ring send error");
+    }
+    return 0;
+}
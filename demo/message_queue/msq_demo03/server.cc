@@ -0,0 +1,21 @@
+#include "shm_ring.hpp"
+
+int main()
+{
+    shm_unlink(RING_NAME); // 清理上次被 Ctrl+C 结束时遗留的队列
+    ShmRing *ring = CreateRing();
+    char buffer[BUFF_SIZE + 1];
+    while (true)
+    {
+        ssize_t n = RingRecv(ring, buffer, BUFF_SIZE);
+        if (n < 0)
+        {
+            perror("ring recv error");
+            break;
+        }
+        buffer[n] = '\0';
+        std::cout << "Client say@ " << buffer << std::endl;
+    }
+    DeleteRing(ring);
+    return 0;
+}
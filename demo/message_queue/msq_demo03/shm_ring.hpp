@@ -0,0 +1,255 @@
+#pragma once
+#include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// 共享内存 MPSC 环形队列：多个 client 进程写 一个 server 进程读
+// 与 msq_demo02 的 com.hpp 用法一致：server 调 CreateRing() client 调 GetRing()
+// 快路径（队列非空 / 非满）只有用户态原子操作 不进内核
+// 对方睡着时才用 futex 唤醒
+
+const char *const RING_NAME = "/shm_ring_demo";
+const int RING_SLOTS = 256;     // 槽位数 必须是 2 的幂
+const int BUFF_SIZE = 1024;     // 单条消息最大长度 与 msq_demo02 相同
+const int SPIN_COUNT = 200;     // 进 futex 睡眠前先自旋的次数
+
+enum
+{
+    RING_CREAT_ERR = 1,
+    RING_GET_ERR,
+    RING_DELETE_ERR
+};
+
+// 每个槽位带一个序号（Vyukov 有界队列）：
+// seq == pos      槽位空闲 可以写入第 pos 条
+// seq == pos + 1  第 pos 条已写完 可以读取
+struct alignas(64) RingSlot
+{
+    std::atomic<uint64_t> seq;
+    uint32_t len;
+    char data[BUFF_SIZE];
+};
+
+struct ShmRing
+{
+    alignas(64) std::atomic<uint64_t> head;             // 生产者下一次要抢的位置
+    alignas(64) std::atomic<uint64_t> tail;             // 消费者下一次要读的位置
+    alignas(64) std::atomic<uint32_t> consumer_sleeping;// 1 表示消费者准备/正在 futex 睡眠
+    std::atomic<uint32_t> space_seq;                    // 消费者每腾出空位且有人等时加 1
+    std::atomic<uint32_t> producers_sleeping;           // 等空位的生产者个数
+    RingSlot slots[RING_SLOTS];
+};
+
+// 共享内存里的 futex 不能用 *_PRIVATE 版本 要跨进程可见
+static inline long futex(std::atomic<uint32_t> *addr, int op, uint32_t val)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), op, val, nullptr, nullptr, 0);
+}
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static ShmRing *MapRing(int fd)
+{
+    void *p = mmap(nullptr, sizeof(ShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? nullptr : static_cast<ShmRing *>(p);
+}
+
+// server 端：创建并初始化
+ShmRing *CreateRing(const char *name = RING_NAME)
+{
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0 || ftruncate(fd, sizeof(ShmRing)) < 0)
+    {
+        perror("ring create error");
+        exit(RING_CREAT_ERR);
+    }
+    ShmRing *ring = MapRing(fd);
+    if (ring == nullptr)
+    {
+        perror("ring mmap error");
+        exit(RING_CREAT_ERR);
+    }
+    // ftruncate 出来的内存全为 0 只需设置各槽位的初始序号
+    for (int i = 0; i < RING_SLOTS; i++)
+        ring->slots[i].seq.store(i, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return ring;
+}
+
+// client 端：打开 server 已创建好的队列
+ShmRing *GetRing(const char *name = RING_NAME)
+{
+    int fd = shm_open(name, O_RDWR, 0666);
+    if (fd < 0)
+    {
+        perror("ring get error");
+        exit(RING_GET_ERR);
+    }
+    ShmRing *ring = MapRing(fd);
+    if (ring == nullptr)
+    {
+        perror("ring mmap error");
+        exit(RING_GET_ERR);
+    }
+    return ring;
+}
+
+void DeleteRing(ShmRing *ring, const char *name = RING_NAME)
+{
+    munmap(ring, sizeof(ShmRing));
+    if (shm_unlink(name) < 0)
+    {
+        perror("ring delete error");
+        exit(RING_DELETE_ERR);
+    }
+}
+
+static inline bool RingHasData(ShmRing *ring)
+{
+    uint64_t pos = ring->tail.load(std::memory_order_relaxed);
+    return ring->slots[pos & (RING_SLOTS - 1)].seq.load(std::memory_order_acquire) == pos + 1;
+}
+
+static inline bool RingHasSpace(ShmRing *ring)
+{
+    uint64_t pos = ring->head.load(std::memory_order_relaxed);
+    return ring->slots[pos & (RING_SLOTS - 1)].seq.load(std::memory_order_acquire) == pos;
+}
+
+// 非阻塞发送 队列满返回 false 且 errno 为 EAGAIN
+// 消息超过 BUFF_SIZE 返回 false 且 errno 为 EMSGSIZE（与 mq_send 一致 不截断）
+bool TryRingSend(ShmRing *ring, const void *buf, size_t len)
+{
+    if (len > BUFF_SIZE)
+    {
+        errno = EMSGSIZE;
+        return false;
+    }
+    uint64_t pos = ring->head.load(std::memory_order_relaxed);
+    RingSlot *slot;
+    for (;;)
+    {
+        slot = &ring->slots[pos & (RING_SLOTS - 1)];
+        uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        int64_t dif = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (dif == 0)
+        {
+            if (ring->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {
+            errno = EAGAIN;
+            return false;
+        }
+        else
+            pos = ring->head.load(std::memory_order_relaxed);
+    }
+    slot->len = static_cast<uint32_t>(len);
+    memcpy(slot->data, buf, len);
+    slot->seq.store(pos + 1, std::memory_order_release);
+
+    // 和消费者的 "先置 sleeping 再检查队列" 配对 两边至少一方能看到对方
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring->consumer_sleeping.load(std::memory_order_relaxed) &&
+        ring->consumer_sleeping.exchange(0))
+        futex(&ring->consumer_sleeping, FUTEX_WAKE, 1);
+    return true;
+}
+
+// 非阻塞接收 返回消息长度 队列空返回 -1 且 errno 为 EAGAIN（只允许一个消费者）
+// 消息比 cap 长返回 -1 且 errno 为 EMSGSIZE 消息留在队列里 换个够大的缓冲区再收
+ssize_t TryRingRecv(ShmRing *ring, void *buf, size_t cap)
+{
+    uint64_t pos = ring->tail.load(std::memory_order_relaxed);
+    RingSlot *slot = &ring->slots[pos & (RING_SLOTS - 1)];
+    if (slot->seq.load(std::memory_order_acquire) != pos + 1)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+    size_t len = slot->len;
+    if (len > cap)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    memcpy(buf, slot->data, len);
+    slot->seq.store(pos + RING_SLOTS, std::memory_order_release);
+    ring->tail.store(pos + 1, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring->producers_sleeping.load(std::memory_order_relaxed) > 0)
+    {
+        ring->space_seq.fetch_add(1);
+        futex(&ring->space_seq, FUTEX_WAKE, INT_MAX);
+    }
+    return static_cast<ssize_t>(len);
+}
+
+// 阻塞发送：先自旋 仍然满再睡在 space_seq 上
+// 成功返回 0 消息超过 BUFF_SIZE 返回 -1 且 errno 为 EMSGSIZE
+int RingSend(ShmRing *ring, const void *buf, size_t len)
+{
+    if (len > BUFF_SIZE)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    for (int spin = 0; !TryRingSend(ring, buf, len); spin++)
+    {
+        if (spin < SPIN_COUNT)
+        {
+            cpu_relax();
+            continue;
+        }
+        uint32_t seen = ring->space_seq.load(std::memory_order_acquire);
+        ring->producers_sleeping.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!RingHasSpace(ring))
+            futex(&ring->space_seq, FUTEX_WAIT, seen);
+        ring->producers_sleeping.fetch_sub(1);
+        spin = 0;
+    }
+    return 0;
+}
+
+// 阻塞接收：先自旋 仍然空再睡在 consumer_sleeping 上
+// 消息比 cap 长时不等待 直接返回 -1 且 errno 为 EMSGSIZE
+ssize_t RingRecv(ShmRing *ring, void *buf, size_t cap)
+{
+    ssize_t n;
+    for (int spin = 0; (n = TryRingRecv(ring, buf, cap)) < 0; spin++)
+    {
+        if (errno == EMSGSIZE)
+            return -1;
+        if (spin < SPIN_COUNT)
+        {
+            cpu_relax();
+            continue;
+        }
+        ring->consumer_sleeping.store(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!RingHasData(ring))
+            futex(&ring->consumer_sleeping, FUTEX_WAIT, 1);
+        ring->consumer_sleeping.store(0, std::memory_order_relaxed);
+        spin = 0;
+    }
+    return n;
+}
@@ -0,0 +1,435 @@
+// epoll 边沿触发 (EPOLLET) 的回显服务器，作为 io_uring_server 的对照组
+// 端口、协议 (-p echo|line)、线程模型 (-t 每线程一个 epoll + SO_REUSEPORT 监听 socket、-P)、缓冲区大小 (-B) 与 io_uring_server 一致
+// 每个连接一块输入缓冲区和一块输出缓冲区：读到 EAGAIN 为止，解析出所有完整请求，再写到 EAGAIN 为止
+//
+// 编译: make epoll_server
+// 运行: ./epoll_server [-t threads] [-P] [-B bytes] [-p echo|line] [-q]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define PORT 8080
+#define BUF_SIZE 1024
+#define BACKLOG 4096
+#define MAX_CONNECTIONS 65536  // 最大连接数，需小于 ulimit -n
+#define MAX_THREADS 64
+#define MAX_EVENTS 256         // 每次 epoll_wait 最多取回的事件数
+
+typedef struct Conn {
+    int fd;
+    int read_blocked;    // 输入缓冲区满、暂停读取；ET 下不会再通知，输出写空后主动再读
+    size_t in_len;       // 输入缓冲区 [0, in_len) 是未解析的数据
+    size_t out_off;      // 输出缓冲区 [out_off, out_len) 是待发送的数据
+    size_t out_len;
+    char *in;
+    char *out;
+    struct Conn *next_free;
+} Conn;
+
+// 协议回调：返回消费的字节数；0 表示请求不完整或输出缓冲区放不下响应；< 0 协议错误
+typedef int (*proto_handler)(Conn *c, const char *data, size_t len);
+
+typedef struct Worker {
+    int id;
+    int cpu;             // 绑定的 CPU，-1 表示不绑
+    pthread_t thread;
+    int epfd;
+    int listen_socket;
+    Conn *free_conns;    // 关闭的连接连同缓冲区留着复用
+    long allocations;
+    long requests;
+    long loop_iterations;  // epoll_wait 调用次数
+    long events;
+} Worker;
+
+int quiet = 0;      // -q: 不打印每个连接的建立/关闭，压测时用
+int pin_cpu = 1;    // -P 关闭绑核
+size_t buf_size = BUF_SIZE;  // -B: 每个输入 / 输出缓冲区的大小
+proto_handler protocol;      // -p
+volatile sig_atomic_t stop = 0;
+
+// 提升文件描述符限制，几千个连接会超过默认的 1024
+void setup_rlimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        perror("getrlimit");
+        return;
+    }
+    limit.rlim_cur = MAX_CONNECTIONS;
+    if (limit.rlim_cur > limit.rlim_max) limit.rlim_cur = limit.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        perror("setrlimit");
+    }
+}
+
+// ---------------------- 协议 ----------------------
+
+static inline size_t out_free(const Conn *c) {
+    return buf_size - c->out_len;
+}
+
+// 追加响应，放不下时返回 -1 且不写入
+int conn_send(Conn *c, const char *data, size_t len) {
+    if (out_free(c) < len) return -1;
+    memcpy(c->out + c->out_len, data, len);
+    c->out_len += len;
+    return 0;
+}
+
+// echo：收到多少回多少，不区分消息边界
+int proto_echo(Conn *c, const char *data, size_t len) {
+    size_t n = out_free(c);
+    if (n > len) n = len;
+    conn_send(c, data, n);
+    return (int)n;
+}
+
+// line：每个 '\n' 结尾的行是一个请求，原样回一行
+int proto_line(Conn *c, const char *data, size_t len) {
+    const char *nl = memchr(data, '\n', len);
+    if (!nl) return 0;
+    size_t n = nl - data + 1;
+    if (conn_send(c, data, n) < 0) return 0;
+    return (int)n;
+}
+
+// 解析输入缓冲区里所有完整的请求，剩下的半个请求挪到开头；返回请求数，协议错误返回 -1
+int conn_process(Conn *c) {
+    int requests = 0;
+    size_t off = 0;
+    while (off < c->in_len) {
+        // 输出缓冲区写空了就从头开始用
+        if (c->out_off == c->out_len) c->out_off = c->out_len = 0;
+        int n = protocol(c, c->in + off, c->in_len - off);
+        if (n < 0) return -1;
+        if (n == 0) break;
+        off += n;
+        requests++;
+    }
+    if (off > 0) {
+        memmove(c->in, c->in + off, c->in_len - off);
+        c->in_len -= off;
+    }
+    // 输入缓冲区满了、输出缓冲区也空了还解析不出一个请求：请求比缓冲区还大
+    if (c->in_len == buf_size && c->out_len == c->out_off) return -1;
+    return requests;
+}
+
+// ---------------------- 连接 ----------------------
+
+Conn *conn_alloc(Worker *w, int fd) {
+    Conn *c = w->free_conns;
+    if (c) {
+        w->free_conns = c->next_free;
+    } else {
+        c = malloc(sizeof(Conn) + 2 * buf_size);
+        if (!c) return NULL;
+        c->in = (char *)(c + 1);
+        c->out = c->in + buf_size;
+        w->allocations++;
+    }
+    c->fd = fd;
+    c->read_blocked = 0;
+    c->in_len = c->out_off = c->out_len = 0;
+    return c;
+}
+
+void conn_close(Worker *w, Conn *c) {
+    if (!quiet) printf("[%d] Connection closed: FD %d\n", w->id, c->fd);
+    close(c->fd);  // close 会自动从 epoll 里移除
+    c->next_free = w->free_conns;
+    w->free_conns = c;
+}
+
+// 写到 EAGAIN 或写完；返回 -1 表示连接出错
+int conn_flush(Conn *c) {
+    while (c->out_off < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        c->out_off += n;
+    }
+    c->out_off = c->out_len = 0;
+    return 0;
+}
+
+// 读到 EAGAIN / 对端关闭 / 输入缓冲区满为止，每读一次就解析并尽量写出
+// 返回 -1 表示应关闭连接
+int conn_on_readable(Worker *w, Conn *c) {
+    c->read_blocked = 0;
+    for (;;) {
+        if (c->in_len == buf_size) {
+            // 输出写不出去导致输入处理不动：先停读，等 EPOLLOUT 写空后再继续
+            c->read_blocked = 1;
+            return 0;
+        }
+        ssize_t n = recv(c->fd, c->in + c->in_len, buf_size - c->in_len, 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            // 对端关闭：剩余的响应尽量发出去后关闭
+            conn_flush(c);
+            return -1;
+        }
+        c->in_len += n;
+        int r = conn_process(c);
+        if (r < 0) return -1;
+        w->requests += r;
+        if (conn_flush(c) < 0) return -1;
+    }
+}
+
+int conn_on_writable(Worker *w, Conn *c) {
+    if (conn_flush(c) < 0) return -1;
+    if (c->out_off == c->out_len) {
+        // 输出腾空后，之前因为输出满而没处理的请求可以继续
+        int r = conn_process(c);
+        if (r < 0) return -1;
+        w->requests += r;
+        if (conn_flush(c) < 0) return -1;
+        if (c->read_blocked) return conn_on_readable(w, c);
+    }
+    return 0;
+}
+
+// ET 下一次通知后必须 accept 到 EAGAIN，否则剩下的连接不会再通知
+void accept_all(Worker *w) {
+    for (;;) {
+        int fd = accept4(w->listen_socket, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept4");
+            return;
+        }
+        Conn *c = conn_alloc(w, fd);
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        // 读写一次性注册，ET 只在状态变化时通知，不用随读写状态反复 epoll_ctl
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data.ptr = c };
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            perror("epoll_ctl");
+            conn_close(w, c);
+            continue;
+        }
+        if (!quiet) printf("[%d] New connection: FD %d\n", w->id, fd);
+    }
+}
+
+// ---------------------- 线程与监听 socket ----------------------
+
+// 每个 worker 一个监听 socket，SO_REUSEPORT 让内核把新连接分散到各个 socket 上
+int create_listener(void) {
+    struct sockaddr_in server_addr;
+    int server_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (server_socket < 0) {
+        perror("Socket creation failed");
+        return -1;
+    }
+
+    int on = 1;
+    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    setsockopt(server_socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));  // 与 io_uring_server 一致，由 accept 出的连接继承
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(PORT);
+
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        perror("Bind failed");
+        close(server_socket);
+        return -1;
+    }
+    if (listen(server_socket, BACKLOG) < 0) {
+        perror("Listen failed");
+        close(server_socket);
+        return -1;
+    }
+    return server_socket;
+}
+
+void *worker_main(void *arg) {
+    Worker *w = arg;
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err) fprintf(stderr, "[%d] pthread_setaffinity_np: %s\n", w->id, strerror(err));
+    }
+
+    w->epfd = epoll_create1(EPOLL_CLOEXEC);
+    // 监听 socket 的 data.ptr 为 NULL，用来和连接区分
+    struct epoll_event lev = { .events = EPOLLIN | EPOLLET, .data.ptr = NULL };
+    if (w->epfd < 0 || epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->listen_socket, &lev) < 0) {
+        perror("epoll");
+        kill(getpid(), SIGTERM);
+        return NULL;
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!stop) {
+        int n = epoll_wait(w->epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        w->loop_iterations++;
+        w->events += n;
+
+        for (int i = 0; i < n; i++) {
+            Conn *c = events[i].data.ptr;
+            if (!c) {
+                accept_all(w);
+                continue;
+            }
+            uint32_t ev = events[i].events;
+            int bad = 0;
+            if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) bad = conn_on_readable(w, c) < 0;
+            if (!bad && (ev & EPOLLOUT)) bad = conn_on_writable(w, c) < 0;
+            if (bad) conn_close(w, c);
+        }
+    }
+
+    close(w->epfd);
+    return NULL;
+}
+
+// 只用来打断 worker 阻塞中的 epoll_wait
+void handle_wakeup(int sig) {
+    (void)sig;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-t threads] [-P] [-B bytes] [-p echo|line] [-q]\n", prog);
+    fprintf(stderr, "  -t  worker threads, one epoll and one SO_REUSEPORT listener each (default 1)\n");
+    fprintf(stderr, "  -P  don't pin worker threads to CPUs\n");
+    fprintf(stderr, "  -B  per-connection input/output buffer size in bytes (default %d)\n", BUF_SIZE);
+    fprintf(stderr, "  -p  protocol: echo (default) or line, one response per '\\n'-terminated request\n");
+    fprintf(stderr, "  -q  quiet, don't log every connection\n");
+}
+
+int main(int argc, char *argv[]) {
+    int threads = 1;
+    int opt;
+
+    protocol = proto_echo;
+    while ((opt = getopt(argc, argv, "t:PB:p:qh")) != -1) {
+        switch (opt) {
+            case 't':
+                threads = atoi(optarg);
+                break;
+            case 'P':
+                pin_cpu = 0;
+                break;
+            case 'B':
+                buf_size = strtoul(optarg, NULL, 10);
+                break;
+            case 'p':
+                if (strcmp(optarg, "line") == 0) {
+                    protocol = proto_line;
+                } else if (strcmp(optarg, "echo") != 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'q':
+                quiet = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (buf_size == 0 || buf_size > (1u << 30)) {
+        fprintf(stderr, "invalid buffer size\n");
+        return 1;
+    }
+    if (threads < 1 || threads > MAX_THREADS) {
+        fprintf(stderr, "threads must be in [1, %d]\n", MAX_THREADS);
+        return 1;
+    }
+
+    setup_rlimit();
+
+    // SIGINT / SIGTERM 只由主线程 sigwait 接收；worker 靠 SIGUSR1 打断阻塞的 epoll_wait
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_wakeup;  // 不设 SA_RESTART，epoll_wait 返回 EINTR
+    sigaction(SIGUSR1, &sa, NULL);
+
+    Worker *workers = calloc(threads, sizeof(Worker));
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 0; i < threads; i++) {
+        workers[i].id = i;
+        workers[i].cpu = pin_cpu ? (int)(i % ncpu) : -1;
+        workers[i].listen_socket = create_listener();
+        if (workers[i].listen_socket < 0) return 1;
+    }
+
+    printf("Server listening on port %d using epoll (%s, edge-triggered, %d thread%s)...\n", PORT,
+           protocol == proto_line ? "line" : "echo", threads, threads > 1 ? "s" : "");
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    int sig;
+    sigwait(&set, &sig);
+    stop = 1;
+    for (int i = 0; i < threads; i++) {
+        while (pthread_tryjoin_np(workers[i].thread, NULL) == EBUSY) {
+            pthread_kill(workers[i].thread, SIGUSR1);
+            usleep(10000);
+        }
+    }
+
+    long requests = 0, allocations = 0, iterations = 0, events = 0;
+    for (int i = 0; i < threads; i++) {
+        Worker *w = &workers[i];
+        requests += w->requests;
+        allocations += w->allocations;
+        iterations += w->loop_iterations;
+        events += w->events;
+        if (threads > 1) fprintf(stderr, "worker %d: requests %ld\n", i, w->requests);
+        close(w->listen_socket);
+    }
+
+    fprintf(stderr, "requests: %ld, allocations: %ld (%.6f per request)\n",
+            requests, allocations, requests ? (double)allocations / requests : 0.0);
+    fprintf(stderr, "epoll_wait calls: %ld, events per call: %.2f\n",
+            iterations, iterations ? (double)events / iterations : 0.0);
+    free(workers);
+    return 0;
+}
@@ -0,0 +1,348 @@
+// uring_file 引擎的 fio 式压测：顺序 / 随机读写，不同块大小和队列深度
+// 每个任务 QD 个 I/O 同时在途，完成回调里立即发下一个，跑满 -t 秒；scan 任务用 fe_scan 顺序预读整个文件
+//
+// 编译: make file_bench
+// 运行: ./file_bench [-f file] [-S MB] [-t seconds] [-q 1,4,16,64] [-b 4,128] [-p read,randread,...] [-B]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "uring_file.h"
+
+#define MAX_LIST 16
+#define MAX_QD 1024
+
+typedef enum { PAT_READ, PAT_RANDREAD, PAT_WRITE, PAT_RANDWRITE, PAT_SCAN } Pattern;
+
+static const char *pattern_names[] = { "read", "randread", "write", "randwrite", "scan" };
+
+typedef struct Job Job;
+
+// 一个 I/O 槽位：整个任务期间反复使用同一个缓冲区
+typedef struct {
+    Job *job;
+    void *buf;
+    long start;
+} IoSlot;
+
+struct Job {
+    FileEngine *e;
+    int fd;
+    Pattern pattern;
+    size_t bs;
+    off_t file_size;
+    off_t next_off;      // 顺序读写的下一个偏移
+    unsigned long rng;
+    long deadline;
+    long ios;
+    long bytes;
+    long lat_sum;        // 每个 I/O 从提交到完成的时间 (ns)
+    long lat_max;
+    int error;
+    IoSlot slots[MAX_QD];
+};
+
+const char *path = "/tmp/uring_file_bench.dat";  // -f
+long file_mb = 256;          // -S
+int runtime = 2;             // -t: 每个任务的秒数
+int direct = 1;              // -B 关闭 O_DIRECT
+unsigned qds[MAX_LIST] = { 1, 4, 16, 64 };
+int nqd = 4;
+unsigned bss[MAX_LIST] = { 4, 128 };  // KB
+int nbs = 2;
+Pattern patterns[MAX_LIST] = { PAT_READ, PAT_RANDREAD, PAT_WRITE, PAT_RANDWRITE, PAT_SCAN };
+int npat = 5;
+
+long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static inline unsigned long xorshift(unsigned long *s) {
+    unsigned long x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+static off_t job_next_offset(Job *job) {
+    off_t blocks = job->file_size / job->bs;
+    if (job->pattern == PAT_RANDREAD || job->pattern == PAT_RANDWRITE) {
+        return (off_t)(xorshift(&job->rng) % blocks) * job->bs;
+    }
+    off_t off = job->next_off;
+    job->next_off += job->bs;
+    if (job->next_off + (off_t)job->bs > job->file_size) job->next_off = 0;
+    return off;
+}
+
+static void io_done(FileEngine *e, int res, void *buf, void *arg);
+
+static void io_submit(Job *job, IoSlot *slot) {
+    off_t off = job_next_offset(job);
+    slot->start = now_ns();
+    int ret = job->pattern == PAT_WRITE || job->pattern == PAT_RANDWRITE
+                  ? fe_write(job->e, job->fd, slot->buf, job->bs, off, io_done, slot)
+                  : fe_read(job->e, job->fd, slot->buf, job->bs, off, io_done, slot);
+    if (ret < 0) job->error = ret;
+}
+
+// 完成回调：记账，没到时间就在同一个槽位上发下一个，队列深度保持不变
+static void io_done(FileEngine *e, int res, void *buf, void *arg) {
+    (void)e;
+    (void)buf;
+    IoSlot *slot = arg;
+    Job *job = slot->job;
+    long now = now_ns();
+    if (res < 0) {
+        job->error = res;
+        return;
+    }
+    long lat = now - slot->start;
+    job->ios++;
+    job->bytes += res;
+    job->lat_sum += lat;
+    if (lat > job->lat_max) job->lat_max = lat;
+    if (now < job->deadline && !job->error) io_submit(job, slot);
+}
+
+// scan：按窗口 qd 顺序预读整个文件，循环直到时间用完
+static void run_scan(Job *job, unsigned qd) {
+    while (now_ns() < job->deadline) {
+        FileScan *s = fe_scan_open(job->e, job->fd, 0, job->file_size, qd);
+        if (!s) {
+            job->error = -errno;
+            return;
+        }
+        void *buf;
+        ssize_t n;
+        long start = now_ns();
+        while ((n = fe_scan_next(s, &buf)) > 0) {
+            long now = now_ns();
+            job->ios++;
+            job->bytes += n;
+            job->lat_sum += now - start;  // 调用方等待每一块的时间，预读充分时接近 0
+            if (now - start > job->lat_max) job->lat_max = now - start;
+            if (now >= job->deadline) break;
+            start = now;
+        }
+        if (n < 0) job->error = (int)n;
+        fe_scan_close(s);
+        if (job->error) return;
+    }
+}
+
+int run_job(Pattern pattern, size_t bs, unsigned qd, off_t file_size) {
+    // 每个任务一个引擎：池里正好 qd 个 bs 大小的缓冲区
+    FileEngine *e = fe_new(qd, bs, qd, direct ? FE_DIRECT : 0);
+    if (!e) {
+        perror("fe_new");
+        return -1;
+    }
+    int fd = fe_open(e, path, O_RDWR, 0);
+    if (fd < 0) {
+        perror(path);
+        fe_free(e);
+        return -1;
+    }
+    Job *job = calloc(1, sizeof(Job));
+    job->e = e;
+    job->fd = fd;
+    job->pattern = pattern;
+    job->bs = bs;
+    job->file_size = file_size;
+    job->rng = 0x9e3779b97f4a7c15UL ^ (unsigned long)now_ns();
+    long begin = now_ns();
+    job->deadline = begin + runtime * 1000000000L;
+
+    if (pattern == PAT_SCAN) {
+        run_scan(job, qd);
+    } else {
+        for (unsigned i = 0; i < qd; i++) {
+            job->slots[i].job = job;
+            job->slots[i].buf = fe_buf_get(e);
+            memset(job->slots[i].buf, 'a' + i % 26, bs);
+            io_submit(job, &job->slots[i]);
+        }
+        // 所有 I/O 都在回调里续发，这里只负责收割
+        while (fe_inflight(e) > 0) {
+            if (fe_poll(e, 1) < 0) break;
+        }
+    }
+    double secs = (now_ns() - begin) / 1e9;
+
+    if (job->error) {
+        fprintf(stderr, "%s bs=%zuk qd=%u: %s\n", pattern_names[pattern], bs / 1024, qd, strerror(-job->error));
+    } else {
+        char label[24];
+        snprintf(label, sizeof(label), "%zuk", bs / 1024);
+        printf("%-10s bs=%-5s qd=%-4u iops=%9.0f  bw=%9.1f MB/s  lat avg=%8.1f us  max=%9.1f us\n",
+               pattern_names[pattern], label, qd, job->ios / secs,
+               job->bytes / secs / 1e6, job->ios ? job->lat_sum / 1e3 / job->ios : 0.0, job->lat_max / 1e3);
+    }
+    int ret = job->error ? -1 : 0;
+    close(fd);
+    free(job);
+    fe_free(e);
+    return ret;
+}
+
+// 布局写的完成回调：记下第一个失败，写不满一整块也算失败
+static void layout_done(FileEngine *e, int res, void *buf, void *arg) {
+    (void)buf;
+    int *error = arg;
+    if (*error == 0 && res < (int)fe_block_size(e)) *error = res < 0 ? res : -EIO;
+}
+
+// 测试文件不存在或不够大时用引擎顺序写满 (QD 16，1MB 一块)
+int prepare_file(off_t size) {
+    struct stat st;
+    if (stat(path, &st) == 0 && st.st_size >= size) return 0;
+    printf("Laying out %s (%ld MB)...\n", path, (long)(size >> 20));
+    size_t bs = 1 << 20;
+    FileEngine *e = fe_new(16, bs, 16, direct ? FE_DIRECT : 0);
+    if (!e) {
+        perror("fe_new");
+        return -1;
+    }
+    int fd = fe_open(e, path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror(path);
+        fe_free(e);
+        return -1;
+    }
+    void *bufs[16];
+    unsigned long rng = 88172645463325252UL;
+    for (int i = 0; i < 16; i++) {
+        bufs[i] = fe_buf_get(e);
+        // 随机内容，避免文件系统 / 设备对全零块做特殊处理
+        for (size_t j = 0; j < bs / sizeof(unsigned long); j++) ((unsigned long *)bufs[i])[j] = xorshift(&rng);
+    }
+    int ret = 0, error = 0;
+    for (off_t off = 0, i = 0; off < size && ret == 0 && error == 0; off += bs, i++) {
+        ret = fe_write(e, fd, bufs[i % 16], bs, off, layout_done, &error);
+    }
+    int drained = fe_drain(e);
+    if (ret == 0) ret = drained;
+    if (ret == 0) ret = error;
+    if (ret == 0 && fsync(fd) < 0) ret = -errno;
+    if (ret < 0) fprintf(stderr, "%s: layout failed: %s\n", path, strerror(-ret));
+    close(fd);
+    fe_free(e);
+    return ret;
+}
+
+int parse_list(const char *s, unsigned *out) {
+    int n = 0;
+    char *copy = strdup(s), *save = NULL;
+    for (char *tok = strtok_r(copy, ",", &save); tok && n < MAX_LIST; tok = strtok_r(NULL, ",", &save)) {
+        out[n++] = strtoul(tok, NULL, 10);
+    }
+    free(copy);
+    return n;
+}
+
+int parse_patterns(const char *s) {
+    int n = 0;
+    char *copy = strdup(s), *save = NULL;
+    for (char *tok = strtok_r(copy, ",", &save); tok && n < MAX_LIST; tok = strtok_r(NULL, ",", &save)) {
+        int found = 0;
+        for (int p = 0; p <= PAT_SCAN; p++) {
+            if (strcmp(tok, pattern_names[p]) == 0) {
+                patterns[n++] = p;
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "unknown pattern: %s\n", tok);
+            n = 0;
+            break;
+        }
+    }
+    free(copy);
+    return n;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-f file] [-S MB] [-t seconds] [-q depths] [-b KB sizes] [-p patterns] [-B]\n", prog);
+    fprintf(stderr, "  -f  test file (default %s), created if missing or too small\n", path);
+    fprintf(stderr, "  -S  test file size in MB (default %ld)\n", file_mb);
+    fprintf(stderr, "  -t  seconds per job (default %d)\n", runtime);
+    fprintf(stderr, "  -q  comma separated queue depths (default 1,4,16,64)\n");
+    fprintf(stderr, "  -b  comma separated block sizes in KB (default 4,128)\n");
+    fprintf(stderr, "  -p  comma separated patterns: read,randread,write,randwrite,scan (default all)\n");
+    fprintf(stderr, "      scan is a sequential read through fe_scan with a prefetch window of qd blocks\n");
+    fprintf(stderr, "  -B  buffered I/O instead of O_DIRECT (reads then mostly hit the page cache)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "f:S:t:q:b:p:Bh")) != -1) {
+        switch (opt) {
+            case 'f':
+                path = optarg;
+                break;
+            case 'S':
+                file_mb = atol(optarg);
+                break;
+            case 't':
+                runtime = atoi(optarg);
+                break;
+            case 'q':
+                nqd = parse_list(optarg, qds);
+                break;
+            case 'b':
+                nbs = parse_list(optarg, bss);
+                break;
+            case 'p':
+                npat = parse_patterns(optarg);
+                if (npat == 0) return 1;
+                break;
+            case 'B':
+                direct = 0;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    for (int i = 0; i < nqd; i++) {
+        if (qds[i] == 0 || qds[i] > MAX_QD) {
+            fprintf(stderr, "queue depth must be in [1, %d]\n", MAX_QD);
+            return 1;
+        }
+    }
+    for (int i = 0; i < nbs; i++) {
+        if (bss[i] == 0 || (direct && bss[i] % (FE_ALIGN / 1024))) {
+            fprintf(stderr, "block size must be a positive multiple of %dKB with O_DIRECT\n", FE_ALIGN / 1024);
+            return 1;
+        }
+    }
+    off_t size = (off_t)file_mb << 20;
+    // 随机读写按 file_size / bs 个块取模，文件至少要有一块
+    for (int i = 0; i < nbs; i++) {
+        if ((off_t)bss[i] * 1024 > size) {
+            fprintf(stderr, "file size (%ld MB) must be at least the block size (%uKB)\n", file_mb, bss[i]);
+            return 1;
+        }
+    }
+    if (prepare_file(size) < 0) return 1;
+
+    printf("file %s, %ld MB, %s, %d s per job\n", path, file_mb, direct ? "O_DIRECT" : "buffered", runtime);
+    for (int p = 0; p < npat; p++) {
+        for (int b = 0; b < nbs; b++) {
+            for (int q = 0; q < nqd; q++) {
+                run_job(patterns[p], (size_t)bss[b] * 1024, qds[q], size);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "frame.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <arpa/inet.h>
+
+void frame_header_pack(void *dst, uint32_t type, uint32_t len) {
+    uint32_t h[2] = { htonl(type), htonl(len) };
+    memcpy(dst, h, FRAME_HDR_SIZE);
+}
+
+static inline void header_unpack(const void *src, FrameHeader *hdr) {
+    uint32_t h[2];
+    memcpy(h, src, FRAME_HDR_SIZE);  // 输入可能没对齐
+    hdr->type = ntohl(h[0]);
+    hdr->len = ntohl(h[1]);
+}
+
+ssize_t frame_parse(const void *data, size_t len, uint32_t max_payload, FrameHeader *hdr) {
+    if (len < FRAME_HDR_SIZE) return 0;
+    header_unpack(data, hdr);
+    if (hdr->len > max_payload) return -EMSGSIZE;
+    size_t total = FRAME_HDR_SIZE + (size_t)hdr->len;
+    return len < total ? 0 : (ssize_t)total;
+}
+
+int frame_encode_iov(void *hdr_buf, uint32_t type, const struct iovec *payload, int n, struct iovec *out) {
+    size_t len = 0;
+    for (int i = 0; i < n; i++) {
+        len += payload[i].iov_len;
+        out[i + 1] = payload[i];
+    }
+    if (len > UINT32_MAX) return -EMSGSIZE;
+    frame_header_pack(hdr_buf, type, (uint32_t)len);
+    out[0].iov_base = hdr_buf;
+    out[0].iov_len = FRAME_HDR_SIZE;
+    return n + 1;
+}
+
+size_t frame_encode(void *dst, size_t cap, uint32_t type, const void *payload, uint32_t len) {
+    size_t total = FRAME_HDR_SIZE + (size_t)len;
+    if (cap < total) return 0;
+    frame_header_pack(dst, type, len);
+    memcpy((char *)dst + FRAME_HDR_SIZE, payload, len);
+    return total;
+}
+
+void frame_decoder_init(FrameDecoder *d, uint32_t max_payload) {
+    memset(d, 0, sizeof(*d));
+    d->max_payload = max_payload;
+}
+
+void frame_decoder_free(FrameDecoder *d) {
+    free(d->body);
+    d->body = NULL;
+    d->body_cap = 0;
+}
+
+int frame_decode(FrameDecoder *d, const void *data, size_t len, frame_cb cb, void *arg) {
+    const char *p = data;
+    while (len > 0) {
+        if (!d->in_body && d->have == 0) {
+            // 快速路径：不在半帧中间时，完整落在输入里的帧直接回调，不拷贝
+            FrameHeader hdr;
+            ssize_t n = frame_parse(p, len, d->max_payload, &hdr);
+            if (n < 0) return (int)n;
+            if (n > 0) {
+                int ret = cb(arg, hdr.type, p + FRAME_HDR_SIZE, hdr.len);
+                if (ret) return ret;
+                p += n;
+                len -= n;
+                continue;
+            }
+        }
+        if (!d->in_body) {
+            // 头被切开了：先攒够 8 字节
+            size_t take = FRAME_HDR_SIZE - d->have;
+            if (take > len) take = len;
+            memcpy(d->hdr_buf + d->have, p, take);
+            d->have += take;
+            p += take;
+            len -= take;
+            if (d->have < FRAME_HDR_SIZE) break;
+            header_unpack(d->hdr_buf, &d->hdr);
+            if (d->hdr.len > d->max_payload) return -EMSGSIZE;
+            d->in_body = 1;
+            d->have = 0;
+            if (d->hdr.len > d->body_cap) {
+                char *body = realloc(d->body, d->hdr.len);
+                if (!body) return -ENOMEM;
+                d->body = body;
+                d->body_cap = d->hdr.len;
+            }
+        }
+        size_t take = d->hdr.len - d->have;
+        if (take > len) take = len;
+        if (take) memcpy(d->body + d->have, p, take);
+        d->have += take;
+        p += take;
+        len -= take;
+        if (d->have < d->hdr.len) break;
+        d->in_body = 0;
+        d->have = 0;
+        int ret = cb(arg, d->hdr.type, d->body, d->hdr.len);
+        if (ret) return ret;
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+// 长度前缀分帧：8 字节头 (type u32 + len u32，网络字节序) + len 字节 payload
+// 与 input-linux/input-sim 里 kernel_sim_server 的 MsgHeader 格式相同
+//
+// 编码：frame_encode_iov 把头和调用方的多段 payload 组成 iovec，直接交给 writev / sendmsg，payload 不拷贝
+// 解码：
+//   frame_parse   无状态，看一段连续内存开头是不是一个完整的帧；调用方自己缓冲数据时用 (如 io_uring_server 的输入环)
+//   FrameDecoder  有状态，喂入任意切分的字节流 (非阻塞 socket 的每次 recv)，每凑齐一帧回调一次；
+//                 帧整个落在本次数据里时 payload 直接指向输入，只有跨越多次调用的帧才拷贝
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_HDR_SIZE 8
+
+typedef struct {
+    uint32_t type;
+    uint32_t len;
+} FrameHeader;
+
+// io_uring_server -p frame 的消息类型，响应类型 = 请求类型 + 100
+enum {
+    MSG_ECHO = 1,        // 原样返回 payload
+    MSG_PING = 2,        // 返回空的 MSG_PONG
+    MSG_ECHO_R = 101,
+    MSG_PONG = 102,
+    MSG_ERROR = 199,     // 不认识的请求，payload 是它的 type (u32，网络字节序)
+    MSG_TYPE_MAX = 256,
+};
+
+// 在 dst 写入网络字节序的头
+void frame_header_pack(void *dst, uint32_t type, uint32_t len);
+
+// 解析 data 开头的帧头，payload 超过 max_payload 返回 -EMSGSIZE
+// 数据不够一个完整的帧返回 0，否则返回整帧长度 (头 + payload)，*hdr 为主机字节序的头
+ssize_t frame_parse(const void *data, size_t len, uint32_t max_payload, FrameHeader *hdr);
+
+// 组帧：out[0] 指向 hdr_buf (至少 FRAME_HDR_SIZE 字节，在发送完成前保持有效)，后面依次是 payload 的 n 段
+// out 至少要有 n + 1 个元素；返回 iovec 数，payload 总长超过 UINT32_MAX 返回 -EMSGSIZE
+int frame_encode_iov(void *hdr_buf, uint32_t type, const struct iovec *payload, int n, struct iovec *out);
+
+// 组帧到连续缓冲区，空间不够返回 0，否则返回写入的字节数
+size_t frame_encode(void *dst, size_t cap, uint32_t type, const void *payload, uint32_t len);
+
+// 返回非 0 时 frame_decode 停止解析并把它作为返回值
+typedef int (*frame_cb)(void *arg, uint32_t type, const char *payload, uint32_t len);
+
+typedef struct {
+    uint32_t max_payload;
+    FrameHeader hdr;
+    int in_body;         // 0：在读头，1：在读 payload
+    size_t have;         // 当前头 / payload 已收到的字节数
+    char hdr_buf[FRAME_HDR_SIZE];
+    char *body;          // 跨越多次调用的 payload 拼接在这里，按需扩容
+    size_t body_cap;
+} FrameDecoder;
+
+void frame_decoder_init(FrameDecoder *d, uint32_t max_payload);
+void frame_decoder_free(FrameDecoder *d);
+
+// 解析 data 里的全部字节，返回 0；帧太长返回 -EMSGSIZE，内存不足返回 -ENOMEM，回调返回非 0 时原样返回
+// 出错后解码器状态不再可用，应当关闭连接
+int frame_decode(FrameDecoder *d, const void *data, size_t len, frame_cb cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
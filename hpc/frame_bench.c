@@ -0,0 +1,178 @@
+// frame 编解码微基准：预先生成一段帧流，按不同大小切块喂给 FrameDecoder，模拟每次 recv 拿到的数据量
+// chunk 越小，跨块的帧越多、拷贝越多；whole 是整段一次喂入，全部走零拷贝快速路径
+// 另外测 frame_parse 直接扫连续内存 (io_uring_server 输入环的用法) 和两种编码方式
+//
+// 编译: make frame_bench
+// 运行: ./frame_bench [-n frames] [-P max payload] [-r rounds]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "frame.h"
+
+long nframes = 1000000;   // -n
+uint32_t max_payload = 256;  // -P: payload 长度在 [0, max_payload] 里均匀随机
+int rounds = 5;           // -r: 每项取最快的一轮
+
+typedef struct {
+    long frames;
+    unsigned long sum;    // 累加 type 和 payload 首字节，防止回调被优化掉
+} DecodeStats;
+
+long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int on_frame(void *arg, uint32_t type, const char *payload, uint32_t len) {
+    DecodeStats *st = arg;
+    st->frames++;
+    st->sum += type + len + (len ? (unsigned char)payload[0] : 0);
+    return 0;
+}
+
+// 返回最快一轮的耗时 (ns)
+long bench_decode(const char *stream, size_t size, size_t chunk, unsigned long *sum) {
+    long best = 0;
+    for (int r = 0; r < rounds; r++) {
+        FrameDecoder d;
+        frame_decoder_init(&d, max_payload);
+        DecodeStats st = { 0, 0 };
+        long start = now_ns();
+        for (size_t off = 0; off < size; off += chunk) {
+            size_t n = size - off < chunk ? size - off : chunk;
+            if (frame_decode(&d, stream + off, n, on_frame, &st) != 0) {
+                fprintf(stderr, "decode error\n");
+                exit(1);
+            }
+        }
+        long t = now_ns() - start;
+        frame_decoder_free(&d);
+        if (st.frames != nframes) {
+            fprintf(stderr, "decoded %ld frames, expected %ld\n", st.frames, nframes);
+            exit(1);
+        }
+        *sum = st.sum;
+        if (best == 0 || t < best) best = t;
+    }
+    return best;
+}
+
+long bench_parse(const char *stream, size_t size, unsigned long *sum) {
+    long best = 0;
+    for (int r = 0; r < rounds; r++) {
+        DecodeStats st = { 0, 0 };
+        long start = now_ns();
+        FrameHeader hdr;
+        ssize_t n;
+        for (size_t off = 0; (n = frame_parse(stream + off, size - off, max_payload, &hdr)) > 0; off += n) {
+            on_frame(&st, hdr.type, stream + off + FRAME_HDR_SIZE, hdr.len);
+        }
+        long t = now_ns() - start;
+        *sum = st.sum;
+        if (best == 0 || t < best) best = t;
+    }
+    return best;
+}
+
+void report(const char *name, long ns, size_t size) {
+    printf("%-22s %9.1f MB/s %9.2f M frames/s %7.1f ns/frame\n", name, size / (ns / 1e9) / 1e6,
+           nframes / (ns / 1e9) / 1e6, (double)ns / nframes);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:P:r:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                nframes = atol(optarg);
+                break;
+            case 'P':
+                max_payload = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                rounds = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n frames] [-P max payload bytes] [-r rounds]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (nframes <= 0 || rounds <= 0) {
+        fprintf(stderr, "frames and rounds must be positive\n");
+        return 1;
+    }
+
+    // 生成帧流，顺便测编码：连续缓冲区 frame_encode
+    size_t cap = (size_t)nframes * (FRAME_HDR_SIZE + max_payload);
+    char *stream = malloc(cap);
+    uint32_t *lens = malloc(sizeof(uint32_t) * nframes);
+    char *payload = malloc(max_payload + 1);
+    memset(payload, 'x', max_payload + 1);
+    unsigned long rng = 2463534242UL;
+    for (long i = 0; i < nframes; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        lens[i] = rng % (max_payload + 1);
+    }
+    size_t size = 0;
+    long t_encode = 0;
+    for (int r = 0; r < rounds; r++) {
+        long start = now_ns();
+        size = 0;
+        for (long i = 0; i < nframes; i++) {
+            size += frame_encode(stream + size, cap - size, MSG_ECHO, payload, lens[i]);
+        }
+        long t = now_ns() - start;
+        if (t_encode == 0 || t < t_encode) t_encode = t;
+    }
+
+    // 组 iovec 只写 8 字节头，payload 不动，代价与 payload 大小无关
+    long t_iov = 0;
+    struct iovec out[2];
+    char hdr[FRAME_HDR_SIZE];
+    unsigned long iov_sum = 0;
+    for (int r = 0; r < rounds; r++) {
+        long start = now_ns();
+        for (long i = 0; i < nframes; i++) {
+            struct iovec body = { payload, lens[i] };
+            frame_encode_iov(hdr, MSG_ECHO, &body, 1, out);
+            iov_sum += out[1].iov_len + (unsigned char)hdr[7];
+        }
+        long t = now_ns() - start;
+        if (t_iov == 0 || t < t_iov) t_iov = t;
+    }
+
+    printf("%ld frames, payload 0..%u bytes, %.1f MB stream, best of %d rounds\n",
+           nframes, max_payload, size / 1e6, rounds);
+    report("encode (copy)", t_encode, size);
+    report("encode (iovec)", t_iov, size);
+
+    unsigned long sum = 0, expect = 0;
+    report("parse (contiguous)", bench_parse(stream, size, &expect), size);
+    const size_t chunks[] = { 7, 64, 1460, 16384, 0 };
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        size_t chunk = chunks[i] ? chunks[i] : size;
+        char name[48];
+        if (chunks[i]) {
+            snprintf(name, sizeof(name), "decode chunk=%zu", chunk);
+        } else {
+            snprintf(name, sizeof(name), "decode chunk=whole");
+        }
+        report(name, bench_decode(stream, size, chunk, &sum), size);
+        if (sum != expect) {
+            fprintf(stderr, "checksum mismatch at chunk %zu\n", chunk);
+            return 1;
+        }
+    }
+    if (iov_sum == 42) printf("\n");  // 让编译器保留 iovec 循环
+
+    free(payload);
+    free(lens);
+    free(stream);
+    return 0;
+}
@@ -1,105 +1,604 @@
+// io_uring 压测客户端 / 负载发生器
+// 每个线程一个 ring，负责一部分连接；每个连接最多 depth 个请求在途，同一时刻一个 send、一个 recv
+//
+// 两种模式：
+//   闭环 (默认)：响应回来就发下一个，测最大吞吐；延迟从实际发出算起
+//   开环 (-r rate)：请求按固定速率排好时间表，延迟从 "计划发出时间" 算起
+//     服务端变慢时排队的请求照样计入延迟，避免 coordinated omission 把尾延迟藏起来
+// 延迟记入 HDR 风格的对数-线性直方图 (相对误差 < 2%)，-H 打印完整百分位分布
+// -x：每个请求是一个 MSG_ECHO 帧 (frame.h)，配合服务端 -p frame；响应同样大小，计数方式不变
+// -l ms：slowloris 模式，只慢慢发字节、永远不凑成完整请求，用来检验服务端的空闲回收和连接数上限
+// -f path：请求变成 "GET path\n"，配合服务端 -p get 测文件下载，响应按 "OK <size>\n" 头部解析
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <getopt.h>
 #include <pthread.h>
 #include <arpa/inet.h>
-#include <sys/time.h>
-#include <stdatomic.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <liburing.h>
 
-#define SERVER_IP "127.0.0.1"
-#define PORT 8080
+#include "frame.h"
 
-// --- 配置区域 ---
-#define THREAD_COUNT 50     // 模拟并发线程数 (并发连接数)
-#define REQUESTS_PER_THREAD 20000 // 每个线程发送多少个包
-#define MSG_SIZE 64        // 每个包的大小 (字节)
-// ----------------
+#define QUEUE_DEPTH 1024
+#define MAX_THREADS 64
+#define GET_RECV_BUF (64 * 1024)  // -f 模式的 recv 缓冲区，响应体只计数不保存
 
-char message[MSG_SIZE];
-atomic_long total_requests = 0;
-atomic_long total_bytes = 0;
-atomic_int completed_threads = 0;
+// ---------------------- 直方图 ----------------------
+// 小于 2^HIST_SUB_BITS 的值精确记录；更大的值按最高位分段，每段 2^(HIST_SUB_BITS-1) 个桶
+#define HIST_SUB_BITS 7
+#define HIST_HALF (1 << (HIST_SUB_BITS - 1))
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 2) * HIST_HALF)
 
-void *worker_thread(void *arg) {
-    int sock;
-    struct sockaddr_in serv_addr;
-    char buffer[1024];
+typedef struct {
+    unsigned long counts[HIST_BUCKETS];
+    unsigned long total;
+    long max;
+} Hist;
 
-    if ((sock = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-        perror("Socket creation error");
-        return NULL;
+static inline int hist_index(long v) {
+    if (v < (1 << HIST_SUB_BITS)) return (int)v;
+    int shift = 63 - __builtin_clzl(v) - (HIST_SUB_BITS - 1);  // v >> shift 落在 [HALF, 2 * HALF)
+    return (shift + 1) * HIST_HALF + (int)((v >> shift) - HIST_HALF);
+}
+
+// 桶的上界 (桶内任意值都不超过它)
+static long hist_value(int idx) {
+    if (idx < (1 << HIST_SUB_BITS)) return idx;
+    int shift = idx / HIST_HALF - 1;
+    long mant = idx % HIST_HALF + HIST_HALF;
+    return ((mant + 1) << shift) - 1;
+}
+
+static inline void hist_record(Hist *h, long v) {
+    if (v < 0) v = 0;
+    h->counts[hist_index(v)]++;
+    h->total++;
+    if (v > h->max) h->max = v;
+}
+
+void hist_merge(Hist *dst, const Hist *src) {
+    for (int i = 0; i < HIST_BUCKETS; i++) dst->counts[i] += src->counts[i];
+    dst->total += src->total;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+long hist_percentile(const Hist *h, double p) {
+    unsigned long target = (unsigned long)(p / 100.0 * h->total + 0.5);
+    if (target == 0) target = 1;
+    unsigned long seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= target) return hist_value(i) < h->max ? hist_value(i) : h->max;
     }
+    return h->max;
+}
 
+// HdrHistogram 的 percentile distribution 格式 (单位 us)，可以直接贴进 HdrHistogram 的绘图工具
+void hist_print(const Hist *h) {
+    printf("%12s %14s %10s %14s\n", "Value(us)", "Percentile", "TotalCount", "1/(1-Percentile)");
+    unsigned long seen = 0;
+    double next = 0.0;
+    for (int i = 0; i < HIST_BUCKETS && seen < h->total; i++) {
+        if (!h->counts[i]) continue;
+        seen += h->counts[i];
+        double p = (double)seen / h->total;
+        // 每往尾部走一半打一行：50%、75%、87.5%…，和 HdrHistogram 的默认输出一样越靠尾越密
+        if (p >= next || seen == h->total) {
+            long v = hist_value(i) < h->max ? hist_value(i) : h->max;
+            printf("%12.3f %14.12f %10lu %14.2f\n", v / 1000.0, p, seen,
+                   p < 1.0 ? 1.0 / (1.0 - p) : 0.0);
+            next = p + (1.0 - p) / 2;
+        }
+    }
+    printf("#[Max = %.3f, Total count = %lu]\n", h->max / 1000.0, h->total);
+}
+
+// ---------------------- 配置 ----------------------
+
+const char *server_ip = "127.0.0.1";  // -a
+int port = 8080;                      // -p
+int conn_count = 50;                  // -c: 并发连接数
+int requests_per_conn = 20000;        // -m: 每个连接发多少个请求
+int msg_size = 64;                    // -s: 每个请求的大小 (字节)
+int depth = 1;                        // -d: 每个连接最多多少个请求在途 (流水线深度)
+double rate = 0;                      // -r: 开环模式的总目标速率 (请求/秒)，0 为闭环
+int thread_count = 1;                 // -t: 客户端线程数，每个线程一个 ring
+int print_hist = 0;                   // -H
+const char *get_path = NULL;          // -f: 请求服务端 -p get 的文件
+size_t recv_buf_size;
+int slowloris_ms = 0;                 // -l: slowloris 模式每轮的间隔
+int framed = 0;                       // -x
+
+char *message;      // depth 个请求首尾相接，每个以 '\n' 结尾，服务端 -p line 也能按行解析
+
+long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// ---------------------- 连接与线程 ----------------------
+
+enum { OP_RECV, OP_SEND };
+
+typedef struct {
+    int fd;
+    int idx;             // 在本线程连接里的下标，决定开环时间表里的相位
+    int sent;            // 已完整发出的请求数
+    int done;            // 已收到完整响应的请求数
+    int sending;         // 在途 send 包含的请求数，0 表示没有
+    int send_off;        // 这批请求已发出的字节数 (短写续发)
+    int recv_bytes;      // 当前响应已收到的字节数
+    long body_left;      // -f：当前响应体还差的字节数，0 表示在读头部
+    int hdr_len;
+    char hdr[32];        // -f：当前响应的头部行
+    int failed;
+    long *start;         // 环形数组，第 k 个请求的起始时间存在 start[k % depth]
+    char *buf;           // recv 缓冲区
+} Conn;
+
+typedef struct {
+    int id;
+    pthread_t thread;
+    struct io_uring ring;
+    Conn *conns;
+    int nconns;
+    long begin;          // 开环时间表的起点
+    double interval;     // 开环：本线程相邻两个请求的间隔 (ns)
+    long next_req;       // 开环：下一个到期的线程内请求序号，第 j 个请求属于连接 j % nconns
+    int finished;        // 已经结束 (发完收完或出错) 的连接数
+    long requests;
+    long bytes;
+    long errors;
+    long get_errors;     // -f：服务端回 ERR 的请求数
+    Hist hist;
+} Worker;
+
+// 开环模式下连接 c 第 k 个请求的计划发出时间
+static inline long sched_time(Worker *w, Conn *c, int k) {
+    return w->begin + (long)(((double)k * w->nconns + c->idx) * w->interval);
+}
+
+static inline __u64 make_user_data(int conn, int op) {
+    return ((__u64)conn << 1) | op;
+}
+
+static struct io_uring_sqe *get_sqe(Worker *w) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&w->ring);
+    while (!sqe) {
+        io_uring_submit(&w->ring);
+        sqe = io_uring_get_sqe(&w->ring);
+    }
+    return sqe;
+}
+
+void submit_recv(Worker *w, Conn *c) {
+    struct io_uring_sqe *sqe = get_sqe(w);
+    io_uring_prep_recv(sqe, c->fd, c->buf, recv_buf_size, 0);
+    io_uring_sqe_set_data64(sqe, make_user_data(c - w->conns, OP_RECV));
+}
+
+void submit_send(Worker *w, Conn *c) {
+    struct io_uring_sqe *sqe = get_sqe(w);
+    int total = c->sending * msg_size;
+    io_uring_prep_send(sqe, c->fd, message + c->send_off, total - c->send_off, MSG_NOSIGNAL);
+    io_uring_sqe_set_data64(sqe, make_user_data(c - w->conns, OP_SEND));
+}
+
+// 没有在途 send 时，把所有到期且不超过流水线深度的请求合成一次 send
+void try_send(Worker *w, Conn *c, long now) {
+    if (c->sending || c->failed) return;
+    int n = 0;
+    while (c->sent + n < requests_per_conn && c->sent + n - c->done < depth) {
+        int k = c->sent + n;
+        long t;
+        if (rate > 0) {
+            t = sched_time(w, c, k);
+            if (t > now) break;
+        } else {
+            t = now;
+        }
+        c->start[k % depth] = t;
+        n++;
+    }
+    if (n == 0) return;
+    c->sending = n;
+    c->send_off = 0;
+    submit_send(w, c);
+}
+
+static inline void complete_request(Worker *w, Conn *c, long now) {
+    hist_record(&w->hist, now - c->start[c->done % depth]);
+    c->done++;
+    w->requests++;
+}
+
+// -f：响应是头部行 "OK <size>\n" 加 size 字节内容，或者只有 "ERR <errno>\n"
+// 头部可能被拆在两次 recv 里，先攒进 c->hdr；内容只数字节
+void parse_get_responses(Worker *w, Conn *c, const char *p, size_t len, long now) {
+    while (len > 0) {
+        if (c->body_left > 0) {
+            size_t n = len < (size_t)c->body_left ? len : (size_t)c->body_left;
+            c->body_left -= n;
+            p += n;
+            len -= n;
+            if (c->body_left == 0) complete_request(w, c, now);
+            continue;
+        }
+        const char *nl = memchr(p, '\n', len);
+        size_t n = nl ? (size_t)(nl - p) + 1 : len;
+        size_t room = sizeof(c->hdr) - 1 - c->hdr_len;
+        memcpy(c->hdr + c->hdr_len, p, n < room ? n : room);
+        c->hdr_len += n < room ? n : room;
+        p += n;
+        len -= n;
+        if (!nl) break;
+        c->hdr[c->hdr_len] = '\0';
+        c->hdr_len = 0;
+        if (strncmp(c->hdr, "OK ", 3) == 0) {
+            c->body_left = atol(c->hdr + 3);
+        } else {
+            w->get_errors++;
+        }
+        if (c->body_left == 0) complete_request(w, c, now);
+    }
+}
+
+void conn_fail(Worker *w, Conn *c, int res) {
+    if (c->failed) return;
+    if (w->errors++ == 0) fprintf(stderr, "connection error: %s\n", res < 0 ? strerror(-res) : "closed by server");
+    c->failed = 1;
+    w->finished++;
+}
+
+void handle_cqe(Worker *w, struct io_uring_cqe *cqe, long now) {
+    __u64 ud = io_uring_cqe_get_data64(cqe);
+    Conn *c = &w->conns[ud >> 1];
+    if (c->failed) return;
+
+    if ((ud & 1) == OP_SEND) {
+        if (cqe->res <= 0) {
+            conn_fail(w, c, cqe->res);
+            return;
+        }
+        c->send_off += cqe->res;
+        if (c->send_off < c->sending * msg_size) {
+            submit_send(w, c);  // 短写续发
+            return;
+        }
+        c->sent += c->sending;
+        c->sending = 0;
+        try_send(w, c, now);
+        return;
+    }
+
+    if (cqe->res <= 0) {
+        conn_fail(w, c, cqe->res);
+        return;
+    }
+    w->bytes += cqe->res;
+    if (get_path) {
+        parse_get_responses(w, c, c->buf, cqe->res, now);
+    } else {
+        // 响应按请求顺序回来，每凑满 msg_size 字节算完成一个
+        c->recv_bytes += cqe->res;
+        while (c->recv_bytes >= msg_size && c->done < c->sent + c->sending) {
+            c->recv_bytes -= msg_size;
+            complete_request(w, c, now);
+        }
+    }
+    if (c->done == requests_per_conn) {
+        w->finished++;
+        return;
+    }
+    submit_recv(w, c);
+    try_send(w, c, now);
+}
+
+int connect_server(void) {
+    struct sockaddr_in serv_addr;
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        perror("Socket creation error");
+        return -1;
+    }
+    memset(&serv_addr, 0, sizeof(serv_addr));
     serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(PORT);
-    if (inet_pton(AF_INET, SERVER_IP, &serv_addr.sin_addr) <= 0) {
+    serv_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, server_ip, &serv_addr.sin_addr) <= 0) {
         perror("Invalid address");
         close(sock);
-        return NULL;
+        return -1;
     }
-
     if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
         perror("Connection Failed");
         close(sock);
+        return -1;
+    }
+    int on = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return sock;
+}
+
+void *worker_thread(void *arg) {
+    Worker *w = arg;
+    int ret = io_uring_queue_init(QUEUE_DEPTH, &w->ring, 0);
+    if (ret < 0) {
+        fprintf(stderr, "io_uring_queue_init: %s\n", strerror(-ret));
+        w->errors = w->nconns;
         return NULL;
     }
 
-    for (int i = 0; i < REQUESTS_PER_THREAD; i++) {
-        if (send(sock, message, MSG_SIZE, 0) != MSG_SIZE) {
-            perror("Send failed");
-            break;
+    for (int i = 0; i < w->nconns; i++) {
+        Conn *c = &w->conns[i];
+        c->idx = i;
+        c->start = malloc(sizeof(long) * depth);
+        c->buf = malloc(recv_buf_size);
+        c->fd = connect_server();
+        if (c->fd < 0) {
+            c->failed = 1;
+            w->finished++;
+            w->errors++;
         }
+    }
 
-        int valread = read(sock, buffer, 1024);
-        if (valread <= 0) {
-            perror("Read failed or server closed");
+    // 所有连接建好后再开始计时，开环时间表从此刻排起
+    w->begin = now_ns();
+    if (rate > 0) w->interval = 1e9 * thread_count / rate;
+    for (int i = 0; i < w->nconns; i++) {
+        Conn *c = &w->conns[i];
+        if (c->failed) continue;
+        submit_recv(w, c);
+        if (rate <= 0) try_send(w, c, w->begin);
+    }
+
+    long total_reqs = (long)w->nconns * requests_per_conn;
+    while (w->finished < w->nconns) {
+        struct io_uring_cqe *cqe;
+        if (rate > 0) {
+            // 把已经到期的请求派发到各自的连接上 (被流水线深度挡住的在响应回来时再发)
+            long now = now_ns();
+            while (w->next_req < total_reqs) {
+                Conn *c = &w->conns[w->next_req % w->nconns];
+                if (sched_time(w, c, (int)(w->next_req / w->nconns)) > now) break;
+                try_send(w, c, now);
+                w->next_req++;
+            }
+            // 等 CQE，最多等到下一个请求到期
+            struct __kernel_timespec ts = { 0, 0 };
+            if (w->next_req < total_reqs) {
+                Conn *c = &w->conns[w->next_req % w->nconns];
+                long wait = sched_time(w, c, (int)(w->next_req / w->nconns)) - now;
+                if (wait > 0) ts.tv_nsec = wait;
+                ts.tv_sec = ts.tv_nsec / 1000000000L;
+                ts.tv_nsec %= 1000000000L;
+                ret = io_uring_submit_and_wait_timeout(&w->ring, &cqe, 1, &ts, NULL);
+            } else {
+                ret = io_uring_submit_and_wait(&w->ring, 1);
+            }
+        } else {
+            ret = io_uring_submit_and_wait(&w->ring, 1);
+        }
+        if (ret < 0 && ret != -ETIME && ret != -EINTR) {
+            fprintf(stderr, "io_uring_submit_and_wait: %s\n", strerror(-ret));
             break;
         }
-        
-        atomic_fetch_add(&total_requests, 1);
-        atomic_fetch_add(&total_bytes, valread);
+
+        // 同一批 CQE 用同一个时间戳，省掉大量 clock_gettime
+        long now = now_ns();
+        unsigned head, count = 0;
+        io_uring_for_each_cqe(&w->ring, head, cqe) {
+            handle_cqe(w, cqe, now);
+            count++;
+        }
+        io_uring_cq_advance(&w->ring, count);
     }
 
-    close(sock);
-    atomic_fetch_add(&completed_threads, 1);
+    for (int i = 0; i < w->nconns; i++) {
+        Conn *c = &w->conns[i];
+        if (c->fd >= 0) close(c->fd);
+        free(c->start);
+        free(c->buf);
+    }
+    io_uring_queue_exit(&w->ring);
     return NULL;
 }
 
-long get_time_diff_ms(struct timeval start, struct timeval end) {
-    return (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000;
+// slowloris：维持 conn_count 个连接，每轮给每个连接发一个字节 (共 -m 轮)，从不发 '\n'
+// 被服务端关掉的连接下一轮立即重连，保持压力；每轮打印存活连接数和累计被关闭数
+void run_slowloris(void) {
+    int *fds = malloc(sizeof(int) * conn_count);
+    for (int i = 0; i < conn_count; i++) fds[i] = connect_server();
+    long closed = 0, start = now_ns();
+    for (int round = 0; round < requests_per_conn; round++) {
+        int open = 0;
+        for (int i = 0; i < conn_count; i++) {
+            if (fds[i] < 0 && (fds[i] = connect_server()) < 0) continue;
+            // 对端关闭 (FIN 返回 0，RST 返回 -1) 才算被关；EAGAIN 说明连接还在
+            char c;
+            ssize_t n = recv(fds[i], &c, 1, MSG_DONTWAIT);
+            if (n == 0 || (n < 0 && errno != EAGAIN) || send(fds[i], "A", 1, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+                close(fds[i]);
+                fds[i] = -1;
+                closed++;
+                continue;
+            }
+            open++;
+        }
+        printf("t=%5.1fs open: %d, closed by server: %ld\n", (now_ns() - start) / 1e9, open, closed);
+        fflush(stdout);
+        usleep(slowloris_ms * 1000);
+    }
+    for (int i = 0; i < conn_count; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    free(fds);
+}
+
+// 每个连接占一个 fd，几千个连接会超过默认的 1024
+void setup_rlimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-c connections] [-m requests per connection] [-s bytes] [-d depth]\n", prog);
+    fprintf(stderr, "          [-r rate] [-t threads] [-a addr] [-p port] [-f path] [-l ms] [-x] [-H]\n");
+    fprintf(stderr, "  -c  concurrent connections (default %d)\n", conn_count);
+    fprintf(stderr, "  -m  requests per connection (default %d)\n", requests_per_conn);
+    fprintf(stderr, "  -s  request size in bytes, each ends with '\\n' (default %d)\n", msg_size);
+    fprintf(stderr, "  -d  pipeline depth: requests in flight per connection (default %d)\n", depth);
+    fprintf(stderr, "  -r  open loop at this many requests/s in total, latency measured from the\n");
+    fprintf(stderr, "      scheduled send time (default: closed loop, as fast as possible)\n");
+    fprintf(stderr, "  -t  client threads, one io_uring each (default %d)\n", thread_count);
+    fprintf(stderr, "  -a  server address (default %s), -p port (default %d)\n", server_ip, port);
+    fprintf(stderr, "  -f  send \"GET path\\n\" instead (server -p get), throughput counts file bytes\n");
+    fprintf(stderr, "  -x  send MSG_ECHO frames (server -p frame), -s is the whole frame size\n");
+    fprintf(stderr, "  -l  slowloris: every ms send one byte on each connection, never a full request,\n");
+    fprintf(stderr, "      reconnect the ones the server closes; -m is the number of rounds\n");
+    fprintf(stderr, "  -H  print the full latency percentile distribution\n");
 }
 
-int main() {
-    pthread_t threads[THREAD_COUNT];
-    struct timeval start, end;
-    
+int main(int argc, char *argv[]) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:m:s:d:r:t:a:p:f:l:xHh")) != -1) {
+        switch (opt) {
+            case 'c':
+                conn_count = atoi(optarg);
+                break;
+            case 'm':
+                requests_per_conn = atoi(optarg);
+                break;
+            case 's':
+                msg_size = atoi(optarg);
+                break;
+            case 'd':
+                depth = atoi(optarg);
+                break;
+            case 'r':
+                rate = atof(optarg);
+                break;
+            case 't':
+                thread_count = atoi(optarg);
+                break;
+            case 'a':
+                server_ip = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'f':
+                get_path = optarg;
+                break;
+            case 'l':
+                slowloris_ms = atoi(optarg);
+                break;
+            case 'x':
+                framed = 1;
+                break;
+            case 'H':
+                print_hist = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (conn_count <= 0 || requests_per_conn <= 0 || msg_size <= 0 || depth <= 0 || rate < 0) {
+        fprintf(stderr, "connections, requests, message size and depth must be positive\n");
+        return 1;
+    }
+    if (thread_count < 1 || thread_count > MAX_THREADS) {
+        fprintf(stderr, "threads must be in [1, %d]\n", MAX_THREADS);
+        return 1;
+    }
+    if (thread_count > conn_count) thread_count = conn_count;
+
+    setup_rlimit();
+    if (slowloris_ms > 0) {
+        run_slowloris();
+        return 0;
+    }
+
     // 初始化测试数据
-    memset(message, 'A', MSG_SIZE);
+    if (get_path) {
+        msg_size = strlen(get_path) + 5;  // "GET " + path + '\n'
+        message = malloc((size_t)msg_size * depth + 1);
+        for (int i = 0; i < depth; i++) {
+            sprintf(message + (size_t)i * msg_size, "GET %s\n", get_path);
+        }
+        recv_buf_size = GET_RECV_BUF;
+    } else if (framed) {
+        if (msg_size < FRAME_HDR_SIZE) msg_size = FRAME_HDR_SIZE;
+        message = malloc((size_t)msg_size * depth);
+        memset(message, 'A', (size_t)msg_size * depth);
+        for (int i = 0; i < depth; i++) {
+            frame_header_pack(message + (size_t)i * msg_size, MSG_ECHO, msg_size - FRAME_HDR_SIZE);
+        }
+        recv_buf_size = (size_t)msg_size * depth;
+    } else {
+        message = malloc((size_t)msg_size * depth);
+        memset(message, 'A', (size_t)msg_size * depth);
+        for (int i = 1; i <= depth; i++) {
+            message[(size_t)i * msg_size - 1] = '\n';
+        }
+        recv_buf_size = (size_t)msg_size * depth;
+    }
 
     printf("Starting Benchmark...\n");
-    printf("Threads: %d, Requests/Thread: %d, Payload: %d bytes\n", 
-            THREAD_COUNT, REQUESTS_PER_THREAD, MSG_SIZE);
-    printf("Expected Total Requests: %d\n", THREAD_COUNT * REQUESTS_PER_THREAD);
+    printf("Connections: %d, Requests/Connection: %d, Payload: %d bytes, Pipeline depth: %d, Threads: %d\n",
+           conn_count, requests_per_conn, msg_size, depth, thread_count);
+    if (rate > 0) {
+        printf("Open loop, target rate: %.0f req/s\n", rate);
+    } else {
+        printf("Closed loop\n");
+    }
+    printf("Expected Total Requests: %ld\n", (long)conn_count * requests_per_conn);
 
-    gettimeofday(&start, NULL);
+    // 连接平均分给各线程
+    Worker *workers = calloc(thread_count, sizeof(Worker));
+    Conn *conns = calloc(conn_count, sizeof(Conn));
+    for (int i = 0, first = 0; i < thread_count; i++) {
+        Worker *w = &workers[i];
+        w->id = i;
+        w->nconns = conn_count / thread_count + (i < conn_count % thread_count);
+        w->conns = conns + first;
+        first += w->nconns;
+    }
 
-    for (int i = 0; i < THREAD_COUNT; i++) {
-        if (pthread_create(&threads[i], NULL, worker_thread, NULL) != 0) {
+    long start = now_ns();
+    int created = 0;
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i]) != 0) {
             perror("Failed to create thread");
+            break;
         }
+        created++;
     }
 
     // 等待所有线程完成
-    for (int i = 0; i < THREAD_COUNT; i++) {
-        pthread_join(threads[i], NULL);
+    Hist *hist = calloc(1, sizeof(Hist));
+    long reqs = 0, bytes = 0, errors = 0, get_errors = 0;
+    for (int i = 0; i < created; i++) {
+        pthread_join(workers[i].thread, NULL);
+        hist_merge(hist, &workers[i].hist);
+        reqs += workers[i].requests;
+        bytes += workers[i].bytes;
+        errors += workers[i].errors;
+        get_errors += workers[i].get_errors;
     }
-
-    gettimeofday(&end, NULL);
-
-    long duration_ms = get_time_diff_ms(start, end);
-    long reqs = atomic_load(&total_requests);
-    long bytes = atomic_load(&total_bytes);
+    long duration_ms = (now_ns() - start) / 1000000;
+    if (duration_ms <= 0) duration_ms = 1;
 
     double qps = (reqs * 1000.0) / duration_ms;
     double throughput_mb = (bytes / 1024.0 / 1024.0) / (duration_ms / 1000.0);
@@ -107,8 +606,21 @@ int main() {
     printf("\n--- Results ---\n");
     printf("Time taken: %ld ms\n", duration_ms);
     printf("Total Requests: %ld\n", reqs);
+    if (errors) printf("Failed connections: %ld\n", errors);
+    if (get_errors) printf("ERR responses: %ld\n", get_errors);
     printf("QPS: %.2f\n", qps);
     printf("Throughput: %.2f MB/s\n", throughput_mb);
+    if (hist->total) {
+        printf("Latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p999 %.1f  p9999 %.1f  max %.1f\n",
+               hist_percentile(hist, 50) / 1000.0, hist_percentile(hist, 90) / 1000.0,
+               hist_percentile(hist, 99) / 1000.0, hist_percentile(hist, 99.9) / 1000.0,
+               hist_percentile(hist, 99.99) / 1000.0, hist->max / 1000.0);
+        if (print_hist) hist_print(hist);
+    }
 
+    free(hist);
+    free(conns);
+    free(workers);
+    free(message);
     return 0;
-}
\ No newline at end of file
+}
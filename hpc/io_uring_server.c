@@ -2,390 +2,1657 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <liburing.h>
 
+#include "frame.h"
+
 #define PORT 8080
 #define QUEUE_DEPTH 256
 #define BUF_SIZE 1024
+#define BACKLOG 4096
+#define MAX_CONNECTIONS 65536  // 最大连接数，需小于 ulimit -n
+#define MAX_THREADS 64
+#define CQ_ENTRIES (QUEUE_DEPTH * 16)  // multishot 下一个 SQE 会产生很多 CQE，CQ 比 SQ 大得多
+#define WHEEL_SLOTS 64  // 空闲时间轮的槽数，每秒一格；更长的超时转多圈
+#define FD_RESERVE 64   // 每个 worker 给监听 socket、管道、文件缓存等留的 fd
+
+// multishot 模式：provided buffer ring
+#define BUF_RING_ENTRIES 4096  // 共享接收缓冲区个数上限，必须是 2 的幂
+#define BUF_RING_BYTES (4 << 20)  // buffer ring 总内存，-B 调大缓冲区时相应减少个数
+#define BUF_GROUP_ID 0
+
+// -F 模式：发送超过这个长度时用 send_zc，小包零拷贝的通知开销反而更大
+#define ZC_THRESHOLD (16 * 1024)
+
+// -p get：文件缓存与 splice 管道
+#define FILE_CACHE_SIZE 1024       // 每个 worker 的哈希表槽位数，必须是 2 的幂，最多缓存 3/4
+#define FILE_PATH_MAX 256
+#define SPLICE_PIPE_SIZE (256 * 1024)  // 每次 splice 搬运的上限，设置失败时用管道默认的 64KB
 
 // 定义请求类型
 enum {
     EVENT_ACCEPT,
     EVENT_READ,
-    EVENT_WRITE
+    EVENT_WRITE,
+    EVENT_CLOSE,
+    EVENT_FILE_READ,   // -g copy：文件读进输出环
+    EVENT_SPLICE_IN,   // -g splice：文件 -> 管道
+    EVENT_SPLICE_OUT,  // -g splice：管道 -> socket
+    EVENT_TICK,        // 空闲时间轮的 1 秒定时器
+    EVENT_TIMEOUT      // read 的 linked timeout，结果体现在 read 的 -ECANCELED 上，本身忽略
 };
 
-// 用于在 io_uring 中传递上下文信息的结构体
+// user_data 编码：| op 8 位 | buffer id 16 位 | 保留 8 位 | 连接下标 32 位 |
+// 不再为每个请求分配结构体，CQE 里直接解出操作类型和所属连接
+#define UD_OP(ud)  ((int)((ud) >> 56))
+#define UD_BID(ud) ((unsigned short)((ud) >> 40))
+#define UD_IDX(ud) ((unsigned)(ud))
+
+static inline __u64 make_user_data(int op, unsigned short bid, unsigned idx) {
+    return ((__u64)op << 56) | ((__u64)bid << 40) | idx;
+}
+
+// 对象池：每次向系统申请 QUEUE_DEPTH 个对象 (一个 slab)，释放的对象下标挂回空闲栈
+// 连接数稳定后不再 malloc，allocations 只在并发连接数创新高时增长
+#define POOL_MAX_SLABS (MAX_CONNECTIONS / QUEUE_DEPTH)
+
+typedef struct {
+    size_t obj_size;
+    char *slabs[POOL_MAX_SLABS];
+    unsigned nslabs;
+    unsigned *free_ids;  // 空闲对象下标栈
+    unsigned nfree;
+    long allocations;    // 事件循环里的 malloc 次数 (slab 扩容)
+    struct io_uring *fixed_ring;  // 非空时每个新 slab 注册为这个 ring 的一个 fixed buffer，下标即 slab 号
+} Pool;
+
+// 字节环形缓冲区：head / tail 单调递增，对 cap 取模得到下标，used = tail - head
 typedef struct {
+    char *data;
+    size_t head;  // 下一个要消费的字节
+    size_t tail;  // 下一个要写入的位置
+} ByteRing;
+
+struct ConnContext;
+
+// 协议回调：data / len 是输入缓冲区里连续的一段待解析数据
+// 返回消费的字节数；0 表示请求还不完整或输出缓冲区放不下响应，等下次再调；< 0 表示协议错误，关闭连接
+// 响应用 conn_send 追加到输出缓冲区
+typedef int (*proto_handler)(struct ConnContext *ctx, const char *data, size_t len);
+
+// 每个连接一个上下文，整个连接生命周期内复用
+// 读和写各自最多一个在途请求，互不等待：写出输出缓冲区的同时继续往输入缓冲区里读
+typedef struct ConnContext {
+    int fd;              // -F 模式下是 fixed file 表里的下标
+    unsigned id;         // 在 conn_pool 中的下标，编码进 user_data
+    unsigned buf_id;     // buf_pool 中的缓冲区：前 buf_size 字节是输入环，后 buf_size 字节是输出环
+    ByteRing in;
+    ByteRing out;
+    struct iovec in_iov[2];   // 环形缓冲区绕回时读写分成两段
+    struct iovec out_iov[2];
+    int reading;         // 有在途的 read / multishot recv (包括排在 starved 链表上)
+    int writing;         // 有在途的 write；send_zc 要等到 F_NOTIF 才清零
+    int eof;             // 对端关闭了写方向，处理完剩余输入、写完输出后关闭
+    int closing;         // 出错，丢弃所有数据，等在途请求结束后关闭
+    int recv_paused;     // multishot：缓冲区耗尽时自己还压着未处理的数据，先不重新挂 recv
+    int starved;         // multishot：挂在 starved 链表上
+    int linearize_wait;  // legacy：请求跨过了输入环末尾，要等在途 read 结束才能原地旋转
+    int read_cancelling; // legacy：为了线性化已提交取消在途 read 的请求
+    size_t zc_sent;      // send_zc 已发送的字节数，F_NOTIF 之后才能从输出环里释放
+    int pend_head;       // multishot：输入环放不下、暂存在 provided buffer 里的数据 (bid 链表)
+    int pend_tail;
+    int file_fd;         // -p get：正在发送的文件 (文件缓存持有，不由连接关闭)，-1 表示没有
+    off_t file_off;
+    size_t file_left;    // 还没读进输出环 (copy) / 还没进管道 (splice) 的字节数
+    int file_busy;       // 在途的文件 read / splice 请求数
+    long pipe_bytes;     // splice：已进管道、还没写到 socket 的字节数
+    int pipe_fds[2];     // splice：每个连接一个管道，第一次 GET 时创建
+    int pipe_size;
+    unsigned last_active;  // 最近一次完成请求 / 写出数据时的时间轮刻度
+    struct ConnContext *wheel_next;
+    struct ConnContext **wheel_pprev;  // 不在时间轮上时为 NULL
+    struct ConnContext *next_starved;
+} ConnContext;
+
+// 每个线程一个 Worker：自己的 ring、监听 socket (SO_REUSEPORT)、对象池和 buffer ring
+// 线程之间不共享任何可变状态，连接由内核按四元组哈希分到各个监听 socket 上
+typedef struct Worker {
+    int id;
+    int cpu;             // 绑定的 CPU，-1 表示不绑
+    pthread_t thread;
+    struct io_uring ring;
+    int listen_socket;
+    struct sockaddr_in client_addr;
+    socklen_t client_len;
+    Pool conn_pool;
+    Pool buf_pool;
+    struct io_uring_buf_ring *buf_ring;
+    char *buf_base;
+    unsigned buf_entries;
+    int *buf_next;              // 每块 provided buffer 在连接暂存链表里的后继
+    unsigned *buf_off;          // 暂存数据在缓冲区里的起点和长度
+    unsigned *buf_len;
+    ConnContext *starved_head;  // 缓冲区耗尽 (-ENOBUFS) 而停下的连接，等有缓冲区归还再重新挂 recv
+    long requests;              // 协议层处理的请求数
+    long loop_iterations;       // 事件循环轮数，与 requests 对比可看出每轮处理了多少完成事件
+    long cqes_reaped;
+    long file_bytes;            // -p get：发出的文件内容字节数
+    unsigned nconns;            // 当前连接数
+    unsigned max_conns;         // 到上限后暂停 accept
+    int accept_armed;           // 有 accept (或 multishot accept) 在途
+    int accept_cancelling;      // multishot accept 的取消请求已提交
+    int accept_paused;
+    int accept_oneshot;         // multishot：到过上限之后改用单次 accept
+    unsigned tick;              // 时间轮刻度，每秒 +1
+    ConnContext *wheel[WHEEL_SLOTS];
+    struct __kernel_timespec tick_ts;
+    struct __kernel_timespec read_ts;  // 提交后到完成前内核会读它，必须放在不会失效的地方
+    long read_timeouts;         // linked timeout 到期的 read
+    long idle_closed;           // 被时间轮回收的空闲连接
+    long accept_pauses;
+    long cq_overflows;          // 处理完一批 CQE 后发现内核侧还有溢出的次数
+    unsigned cq_dropped;        // 没有 NODROP 时内核丢掉的 CQE 数
+} Worker;
+
+typedef void (*cqe_handler)(Worker *w, struct io_uring_cqe *cqe);
+
+int proto_echo(ConnContext *ctx, const char *data, size_t len);
+
+int quiet = 0;      // -q: 不打印每个连接的建立/关闭，压测时用
+int multishot = 0;  // -m multishot
+int batch = 0;      // -b
+int pin_cpu = 1;    // -P 关闭绑核
+int fixed = 0;      // -F: 注册文件 (direct accept) + 注册缓冲区
+unsigned ring_flags = 0;     // -S / -e 打开的 IORING_SETUP_* 标志
+unsigned sq_idle_ms = 0;     // -i: SQ 线程空闲多久后睡眠，0 用内核默认 (1 秒)
+int sq_cpu = -1;             // -C: SQ 线程绑定的 CPU，多个 worker 时依次 +1
+size_t buf_size = BUF_SIZE;  // -B: 每个输入 / 输出缓冲区的大小
+proto_handler protocol = proto_echo;  // -p
+int splice_files = 1;        // -g: 文件内容用 splice 零拷贝 (1) 还是读进输出环再写 (0)
+const char *doc_root = ".";  // -D: GET 的根目录
+unsigned idle_timeout = 60;  // -I: 多少秒没有完成请求也没有写出数据就关闭连接，0 关闭
+unsigned read_timeout_ms = 0;  // -r: legacy 模式每个 read 的 linked timeout，0 关闭
+unsigned max_conns = 0;      // -c: 所有 worker 合计的最大连接数，0 按 fd 上限自动计算
+volatile sig_atomic_t stop = 0;
+
+// 提升文件描述符限制，几千个连接会超过默认的 1024
+void setup_rlimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        perror("getrlimit");
+        return;
+    }
+    limit.rlim_cur = MAX_CONNECTIONS;
+    if (limit.rlim_cur > limit.rlim_max) limit.rlim_cur = limit.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        perror("setrlimit");
+    }
+}
+
+void pool_init(Pool *pool, size_t obj_size) {
+    memset(pool, 0, sizeof(*pool));
+    pool->obj_size = obj_size;
+    pool->free_ids = malloc(sizeof(unsigned) * MAX_CONNECTIONS);
+}
+
+static inline void *pool_ptr(Pool *pool, unsigned id) {
+    return pool->slabs[id / QUEUE_DEPTH] + (size_t)(id % QUEUE_DEPTH) * pool->obj_size;
+}
+
+// 取一个对象，池空时再申请一个 slab；超过 MAX_CONNECTIONS 返回 NULL
+void *pool_get(Pool *pool, unsigned *id) {
+    if (pool->nfree == 0) {
+        if (pool->nslabs == POOL_MAX_SLABS) return NULL;
+        char *slab = malloc(pool->obj_size * QUEUE_DEPTH);
+        if (!slab) return NULL;
+        if (pool->fixed_ring) {
+            // 注册后内核长期 pin 住这些页，read_fixed / write_fixed 不用每次再 pin
+            struct iovec iov = { slab, pool->obj_size * QUEUE_DEPTH };
+            int ret = io_uring_register_buffers_update_tag(pool->fixed_ring, pool->nslabs, &iov, NULL, 1);
+            if (ret < 0) {
+                fprintf(stderr, "io_uring_register_buffers_update_tag: %s\n", strerror(-ret));
+                free(slab);
+                return NULL;
+            }
+        }
+        pool->allocations++;
+        unsigned base = pool->nslabs * QUEUE_DEPTH;
+        pool->slabs[pool->nslabs++] = slab;
+        // 倒序入栈，先分配低下标
+        for (unsigned i = QUEUE_DEPTH; i > 0; i--) {
+            pool->free_ids[pool->nfree++] = base + i - 1;
+        }
+    }
+    *id = pool->free_ids[--pool->nfree];
+    return pool_ptr(pool, *id);
+}
+
+static inline void pool_put(Pool *pool, unsigned id) {
+    pool->free_ids[pool->nfree++] = id;
+}
+
+// ---------------------- 环形缓冲区 ----------------------
+
+static inline size_t ring_used(const ByteRing *r) {
+    return r->tail - r->head;
+}
+
+static inline size_t ring_free(const ByteRing *r) {
+    return buf_size - ring_used(r);
+}
+
+// 从 head 开始的连续可读段
+static inline char *ring_read_span(const ByteRing *r, size_t *len) {
+    size_t off = r->head % buf_size;
+    size_t used = ring_used(r);
+    *len = used < buf_size - off ? used : buf_size - off;
+    return r->data + off;
+}
+
+// 从 tail 开始的连续可写段
+static inline char *ring_write_span(const ByteRing *r, size_t *len) {
+    size_t off = r->tail % buf_size;
+    size_t avail = ring_free(r);
+    *len = avail < buf_size - off ? avail : buf_size - off;
+    return r->data + off;
+}
+
+// 可读 (readable = 1) 或可写区域拆成最多两段 iovec，返回段数
+int ring_iov(const ByteRing *r, struct iovec *iov, int readable) {
+    size_t len;
+    char *p = readable ? ring_read_span(r, &len) : ring_write_span(r, &len);
+    size_t total = readable ? ring_used(r) : ring_free(r);
+    iov[0].iov_base = p;
+    iov[0].iov_len = len;
+    if (len == total) return 1;
+    iov[1].iov_base = r->data;
+    iov[1].iov_len = total - len;
+    return 2;
+}
+
+// 尽量多地拷入，返回实际拷入的字节数
+size_t ring_write(ByteRing *r, const char *src, size_t len) {
+    size_t done = 0;
+    while (done < len && ring_free(r) > 0) {
+        size_t span;
+        char *dst = ring_write_span(r, &span);
+        if (span > len - done) span = len - done;
+        memcpy(dst, src + done, span);
+        r->tail += span;
+        done += span;
+    }
+    return done;
+}
+
+static void reverse_bytes(char *p, size_t n) {
+    for (size_t i = 0, j = n; i + 1 < j; i++, j--) {
+        char t = p[i];
+        p[i] = p[j - 1];
+        p[j - 1] = t;
+    }
+}
+
+// 可读数据绕回到了缓冲区开头时，原地旋转成从下标 0 开始的连续一段
+// 只在协议需要看到一个跨越边界的完整请求时才会调用
+void ring_linearize(ByteRing *r) {
+    size_t used = ring_used(r);
+    size_t off = r->head % buf_size;
+    if (off + used <= buf_size) return;
+    // 三次反转把 [off, cap) 旋到前面；空闲区的内容无所谓
+    reverse_bytes(r->data, off);
+    reverse_bytes(r->data + off, buf_size - off);
+    reverse_bytes(r->data, buf_size);
+    r->head = 0;
+    r->tail = used;
+}
+
+// ---------------------- 协议 ----------------------
+
+// 追加响应，输出缓冲区放不下时返回 -1 且不写入任何数据
+int conn_send(ConnContext *ctx, const char *data, size_t len) {
+    if (ring_free(&ctx->out) < len) return -1;
+    ring_write(&ctx->out, data, len);
+    return 0;
+}
+
+// echo：收到多少回多少，不区分消息边界
+int proto_echo(ConnContext *ctx, const char *data, size_t len) {
+    size_t n = ring_free(&ctx->out);
+    if (n > len) n = len;
+    conn_send(ctx, data, n);
+    return (int)n;
+}
+
+// line：每个 '\n' 结尾的行是一个请求，原样回一行
+// 流水线场景下一次读到多个请求，逐个解析、逐个追加响应
+int proto_line(ConnContext *ctx, const char *data, size_t len) {
+    const char *nl = memchr(data, '\n', len);
+    if (!nl) return 0;
+    size_t n = nl - data + 1;
+    if (conn_send(ctx, data, n) < 0) return 0;
+    return (int)n;
+}
+
+// ---------------------- 分帧协议 (-p frame) ----------------------
+// 每个请求是一个 frame.h 格式的帧，按 type 分发给处理函数，响应也是帧
+// 输入环负责跨多次读的缓冲，这里只用无状态的 frame_parse；整帧必须放得进输入环
+
+typedef int (*frame_handler)(ConnContext *ctx, const char *payload, uint32_t len);
+
+// 头和 payload 分两段写进输出环，payload 不先拼到临时缓冲里；放不下返回 -1 且不写入
+int conn_send_frame(ConnContext *ctx, uint32_t type, const void *payload, uint32_t len) {
+    if (ring_free(&ctx->out) < FRAME_HDR_SIZE + (size_t)len) return -1;
+    char hdr[FRAME_HDR_SIZE];
+    frame_header_pack(hdr, type, len);
+    ring_write(&ctx->out, hdr, sizeof(hdr));
+    ring_write(&ctx->out, payload, len);
+    return 0;
+}
+
+static int frame_echo(ConnContext *ctx, const char *payload, uint32_t len) {
+    return conn_send_frame(ctx, MSG_ECHO_R, payload, len);
+}
+
+static int frame_ping(ConnContext *ctx, const char *payload, uint32_t len) {
+    (void)payload;
+    (void)len;
+    return conn_send_frame(ctx, MSG_PONG, NULL, 0);
+}
+
+static const frame_handler frame_routes[MSG_TYPE_MAX] = {
+    [MSG_ECHO] = frame_echo,
+    [MSG_PING] = frame_ping,
+};
+
+// 处理函数返回 -1 表示输出环放不下响应：这一帧先不消费，等写出去一些再重新分发
+int proto_frame(ConnContext *ctx, const char *data, size_t len) {
+    FrameHeader hdr;
+    ssize_t n = frame_parse(data, len, buf_size - FRAME_HDR_SIZE, &hdr);
+    if (n <= 0) return n < 0 ? -1 : 0;
+    frame_handler fn = hdr.type < MSG_TYPE_MAX ? frame_routes[hdr.type] : NULL;
+    int ret;
+    if (fn) {
+        ret = fn(ctx, data + FRAME_HDR_SIZE, hdr.len);
+    } else {
+        uint32_t type = htonl(hdr.type);
+        ret = conn_send_frame(ctx, MSG_ERROR, &type, sizeof(type));
+    }
+    return ret < 0 ? 0 : (int)n;
+}
+
+// ---------------------- 文件服务 (-p get) ----------------------
+// 打开过的文件 fd 和大小缓存在 worker 自己的哈希表里，之后的请求不再 open / fstat
+// 在途的 splice / read 可能还引用着 fd，所以缓存不淘汰；文件被修改后需要重启服务端
+
+typedef struct {
+    char path[FILE_PATH_MAX];  // 空串表示空槽
     int fd;
-    int event_type;
-    char buffer[BUF_SIZE];
-    struct iovec iov;
-} Request;
+    off_t size;
+} CachedFile;
+
+static __thread CachedFile *file_cache;  // 每个 worker 线程一份，线程之间不共享
+static __thread unsigned file_cache_count;
+
+CachedFile *file_lookup(const char *path, int *err) {
+    if (strstr(path, "..")) {
+        *err = EACCES;  // 不允许跳出根目录
+        return NULL;
+    }
+    if (!file_cache) {
+        file_cache = calloc(FILE_CACHE_SIZE, sizeof(CachedFile));
+        if (!file_cache) {
+            *err = ENOMEM;
+            return NULL;
+        }
+    }
+    // FNV-1a
+    unsigned h = 2166136261u;
+    for (const char *p = path; *p; p++) h = (h ^ (unsigned char)*p) * 16777619u;
+    CachedFile *f;
+    for (unsigned i = h & (FILE_CACHE_SIZE - 1);; i = (i + 1) & (FILE_CACHE_SIZE - 1)) {
+        f = &file_cache[i];
+        if (!f->path[0]) break;
+        if (strcmp(f->path, path) == 0) return f;
+    }
+    if (file_cache_count >= FILE_CACHE_SIZE / 4 * 3) {
+        *err = ENFILE;
+        return NULL;
+    }
+
+    char full[FILE_PATH_MAX * 2];
+    snprintf(full, sizeof(full), "%s/%s", doc_root, path);
+    int fd = open(full, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *err = errno;
+        return NULL;
+    }
+    struct stat st;
+    errno = 0;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        *err = errno ? errno : S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+        close(fd);
+        return NULL;
+    }
+    strcpy(f->path, path);
+    f->fd = fd;
+    f->size = st.st_size;
+    file_cache_count++;
+    return f;
+}
+
+void file_cache_close(void) {
+    if (!file_cache) return;
+    for (unsigned i = 0; i < FILE_CACHE_SIZE; i++) {
+        if (file_cache[i].path[0]) close(file_cache[i].fd);
+    }
+    free(file_cache);
+    file_cache = NULL;
+}
+
+// get：请求 "GET <path>\n"，响应 "OK <size>\n" + 文件内容；打不开回 "ERR <errno>\n"
+// 文件内容不经过协议层，由状态机在响应头之后发送；发完之前不解析后面的请求，保证响应顺序
+int proto_get(ConnContext *ctx, const char *data, size_t len) {
+    const char *nl = memchr(data, '\n', len);
+    if (!nl) return 0;
+    size_t n = nl - data + 1;
+    if (n < 5 || memcmp(data, "GET ", 4) != 0) return -1;
+
+    const char *p = data + 4;
+    size_t plen = n - 5;
+    if (plen > 0 && p[plen - 1] == '\r') plen--;
+    while (plen > 0 && *p == '/') p++, plen--;
 
-struct io_uring ring;
+    char path[FILE_PATH_MAX];
+    CachedFile *f = NULL;
+    int err = ENAMETOOLONG;
+    if (plen > 0 && plen < sizeof(path)) {
+        memcpy(path, p, plen);
+        path[plen] = '\0';
+        f = file_lookup(path, &err);
+    } else if (plen == 0) {
+        err = ENOENT;
+    }
+
+    char hdr[32];
+    int hlen = f ? snprintf(hdr, sizeof(hdr), "OK %lld\n", (long long)f->size) : snprintf(hdr, sizeof(hdr), "ERR %d\n", err);
+    if (conn_send(ctx, hdr, hlen) < 0) return 0;
+    if (f && f->size > 0) {
+        ctx->file_fd = f->fd;
+        ctx->file_off = 0;
+        ctx->file_left = f->size;
+    }
+    return (int)n;
+}
+
+static inline int conn_file_pending(const ConnContext *ctx) {
+    return ctx->file_left > 0 || ctx->pipe_bytes > 0 || ctx->file_busy > 0;
+}
+
+// 解析输入缓冲区里所有完整的请求，返回处理的请求数，协议错误返回 -1
+int conn_process(ConnContext *ctx) {
+    int requests = 0;
+    ctx->linearize_wait = 0;
+    while (ring_used(&ctx->in) > 0 && !conn_file_pending(ctx)) {
+        size_t len;
+        char *data = ring_read_span(&ctx->in, &len);
+        int n = protocol(ctx, data, len);
+        if (n < 0) return -1;
+        if (n == 0) {
+            if (len < ring_used(&ctx->in)) {
+                // legacy 模式的 read 直接读进输入环的空闲区，旋转会让在途的 read 落到错误的位置
+                // 先停下，由 conn_pump 取消这个 read，完成之后再来线性化
+                if (!multishot && ctx->reading) {
+                    ctx->linearize_wait = 1;
+                    break;
+                }
+                // 请求跨过了缓冲区末尾，拼成连续的一段再给协议看一次
+                ring_linearize(&ctx->in);
+                continue;
+            }
+            // 输入缓冲区满了、输出缓冲区也空了还解析不出一个请求：请求比缓冲区还大
+            if (ring_free(&ctx->in) == 0 && ring_used(&ctx->out) == 0) return -1;
+            break;
+        }
+        ctx->in.head += n;
+        requests++;
+    }
+    return requests;
+}
+
+// ---------------------- 连接 ----------------------
+
+// ---------------------- 空闲连接回收 ----------------------
+// 时间轮每秒转一格，连接挂在 "last_active + idle_timeout" 对应的槽上
+// 连接活跃时只更新 last_active、不挪链表；槽到期时再检查一遍，还没到期的挂到新位置
+// 只有完成请求或写出数据才算活跃：每隔几秒发一个字节、永远凑不成完整请求的连接 (slowloris) 同样会被回收
+
+static void wheel_add(Worker *w, ConnContext *ctx, unsigned expire) {
+    if (expire - w->tick >= WHEEL_SLOTS) expire = w->tick + WHEEL_SLOTS - 1;
+    if (expire == w->tick) expire++;
+    ConnContext **slot = &w->wheel[expire % WHEEL_SLOTS];
+    ctx->wheel_next = *slot;
+    if (*slot) (*slot)->wheel_pprev = &ctx->wheel_next;
+    *slot = ctx;
+    ctx->wheel_pprev = slot;
+}
+
+static void wheel_del(ConnContext *ctx) {
+    if (!ctx->wheel_pprev) return;
+    *ctx->wheel_pprev = ctx->wheel_next;
+    if (ctx->wheel_next) ctx->wheel_next->wheel_pprev = ctx->wheel_pprev;
+    ctx->wheel_pprev = NULL;
+}
+
+// 为新连接取一个上下文和一块输入/输出缓冲区
+ConnContext *conn_alloc(Worker *w, int fd) {
+    unsigned id;
+    if (w->nconns >= w->max_conns) return NULL;
+    ConnContext *ctx = pool_get(&w->conn_pool, &id);
+    if (!ctx) return NULL;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->fd = fd;
+    ctx->id = id;
+    ctx->pend_head = ctx->pend_tail = -1;
+    ctx->file_fd = ctx->pipe_fds[0] = ctx->pipe_fds[1] = -1;
+    char *buffer = pool_get(&w->buf_pool, &ctx->buf_id);
+    if (!buffer) {
+        pool_put(&w->conn_pool, id);
+        return NULL;
+    }
+    ctx->in.data = buffer;
+    ctx->out.data = buffer + buf_size;
+    ctx->last_active = w->tick;
+    if (idle_timeout) wheel_add(w, ctx, w->tick + idle_timeout);
+    w->nconns++;
+    return ctx;
+}
+
+static inline ConnContext *conn_get(Worker *w, __u64 user_data) {
+    return pool_ptr(&w->conn_pool, UD_IDX(user_data));
+}
+
+// SQ 满时先提交一批再取
+static struct io_uring_sqe *get_sqe(Worker *w) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&w->ring);
+    while (!sqe) {
+        io_uring_submit(&w->ring);
+        sqe = io_uring_get_sqe(&w->ring);
+    }
+    return sqe;
+}
+
+// -F 模式下连接 fd 是 fixed file 下标，每个 SQE 都要带上 IOSQE_FIXED_FILE
+static inline void prep_conn_file(struct io_uring_sqe *sqe) {
+    if (fixed) sqe->flags |= IOSQE_FIXED_FILE;
+}
+
+void recycle_buffer(Worker *w, unsigned short bid);
+
+void accept_update(Worker *w);
+
+void conn_free(Worker *w, ConnContext *ctx) {
+    if (!quiet) printf("[%d] Connection closed: FD %d\n", w->id, ctx->fd);
+    wheel_del(ctx);
+    if (fixed) {
+        // direct descriptor 不在进程 fd 表里，只能通过 ring 关闭
+        struct io_uring_sqe *sqe = get_sqe(w);
+        io_uring_prep_close_direct(sqe, ctx->fd);
+        io_uring_sqe_set_data64(sqe, make_user_data(EVENT_CLOSE, 0, 0));
+    } else {
+        close(ctx->fd);
+    }
+    // 还没拷进输入环的 provided buffer 直接还回去
+    while (ctx->pend_head >= 0) {
+        unsigned short bid = ctx->pend_head;
+        ctx->pend_head = w->buf_next[bid];
+        recycle_buffer(w, bid);
+    }
+    if (ctx->pipe_fds[0] >= 0) {
+        close(ctx->pipe_fds[0]);
+        close(ctx->pipe_fds[1]);
+    }
+    pool_put(&w->buf_pool, ctx->buf_id);
+    pool_put(&w->conn_pool, ctx->id);
+    w->nconns--;
+    if (w->accept_paused) accept_update(w);
+}
+
+// 出错：丢弃待发送的数据，在途的读写用 shutdown 打断，等它们返回后由 conn_pump 释放
+// 对端不读数据时写会一直挂着，所以写在途也要 shutdown
+void conn_abort(Worker *w, ConnContext *ctx) {
+    if (ctx->closing) return;
+    ctx->closing = 1;
+    ctx->out.head = ctx->out.tail;
+    if (ctx->starved) {
+        // 还没真正挂 recv，从 starved 链表里摘掉即可
+        ConnContext **pp = &w->starved_head;
+        while (*pp != ctx) pp = &(*pp)->next_starved;
+        *pp = ctx->next_starved;
+        ctx->starved = 0;
+        ctx->reading = 0;
+    }
+    if (ctx->reading || ctx->writing || ctx->file_busy) {
+        struct io_uring_sqe *sqe = get_sqe(w);
+        io_uring_prep_shutdown(sqe, ctx->fd, SHUT_RDWR);
+        prep_conn_file(sqe);
+        io_uring_sqe_set_data64(sqe, make_user_data(EVENT_CLOSE, 0, 0));
+    }
+}
+
+// 申请 sparse fixed file 表 (direct accept 用) 和 fixed buffer 表
+// 内核不支持时返回 -1，调用方退回普通 fd + 普通缓冲区
+int setup_fixed(Worker *w) {
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    unsigned nfiles = limit.rlim_cur < MAX_CONNECTIONS ? limit.rlim_cur : MAX_CONNECTIONS;
+    int ret = io_uring_register_files_sparse(&w->ring, nfiles);
+    if (ret < 0) {
+        fprintf(stderr, "io_uring_register_files_sparse: %s\n", strerror(-ret));
+        return -1;
+    }
+    // buf_pool 每扩容一个 slab 就注册进这张表，连接的输入/输出环都在里面
+    ret = io_uring_register_buffers_sparse(&w->ring, POOL_MAX_SLABS);
+    if (ret < 0) {
+        fprintf(stderr, "io_uring_register_buffers_sparse: %s\n", strerror(-ret));
+        return -1;
+    }
+    w->buf_pool.fixed_ring = &w->ring;
+    return 0;
+}
 
 // 辅助函数：添加 Accept 请求
-void add_accept_request(int server_socket, struct sockaddr_in *client_addr, socklen_t *client_addr_len) {
-    struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
-    Request *req = malloc(sizeof(Request));
-    req->event_type = EVENT_ACCEPT;
-    req->fd = server_socket;
-
-    io_uring_prep_accept(sqe, server_socket, (struct sockaddr *)client_addr, client_addr_len, 0);
-    io_uring_sqe_set_data(sqe, req);
-}
-
-// 辅助函数：添加 Read 请求
-void add_read_request(int client_socket) {
-    struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
-    Request *req = malloc(sizeof(Request));
-    req->event_type = EVENT_READ;
-    req->fd = client_socket;
-    
-    // 设置 iovec 用于接收数据
-    req->iov.iov_base = req->buffer;
-    req->iov.iov_len = BUF_SIZE;
-
-    io_uring_prep_readv(sqe, client_socket, &req->iov, 1, 0);
-    io_uring_sqe_set_data(sqe, req);
-}
-
-// 辅助函数：添加 Write 请求 (回显数据)
-void add_write_request(int client_socket, char *data, size_t len) {
-    struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
-    Request *req = malloc(sizeof(Request));
-    req->event_type = EVENT_WRITE;
-    req->fd = client_socket;
-
-    // 复制数据到写缓冲区
-    memcpy(req->buffer, data, len);
-    req->iov.iov_base = req->buffer;
-    req->iov.iov_len = len;
-
-    io_uring_prep_writev(sqe, client_socket, &req->iov, 1, 0);
-    io_uring_sqe_set_data(sqe, req);
-}
-
-int main() {
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    int server_socket;
-
-    // 1. 初始化 io_uring
-    if (io_uring_queue_init(QUEUE_DEPTH, &ring, 0) < 0) {
-        perror("io_uring_queue_init");
-        return 1;
+void add_accept_request(Worker *w) {
+    struct io_uring_sqe *sqe = get_sqe(w);
+    w->client_len = sizeof(w->client_addr);
+    if (fixed) {
+        // direct accept：新连接直接放进 fixed file 表，res 是表里的下标
+        io_uring_prep_accept_direct(sqe, w->listen_socket, (struct sockaddr *)&w->client_addr, &w->client_len, 0,
+                                    IORING_FILE_INDEX_ALLOC);
+    } else {
+        io_uring_prep_accept(sqe, w->listen_socket, (struct sockaddr *)&w->client_addr, &w->client_len, 0);
+    }
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_ACCEPT, 0, 0));
+    w->accept_armed = 1;
+}
+
+void add_multishot_accept(Worker *w);
+
+// 保持一个 accept 在途，连接数到上限时停下：新连接留在内核 backlog 里 (满了客户端 SYN 重传)，
+// 服务端的 fd 和内存不再增长；有连接释放后恢复
+void accept_update(Worker *w) {
+    if (w->nconns >= w->max_conns) {
+        if (!w->accept_paused) {
+            w->accept_paused = 1;
+            w->accept_pauses++;
+            w->accept_oneshot = 1;
+        }
+        if (multishot && w->accept_armed && !w->accept_cancelling) {
+            struct io_uring_sqe *sqe = get_sqe(w);
+            io_uring_prep_cancel64(sqe, make_user_data(EVENT_ACCEPT, 0, 0), 0);
+            io_uring_sqe_set_data64(sqe, make_user_data(EVENT_CLOSE, 0, 0));
+            w->accept_cancelling = 1;
+        }
+        return;
+    }
+    w->accept_paused = 0;
+    if (!w->accept_armed) {
+        // multishot accept 一挂上就会把 backlog 里排队的连接全部取走，远远越过上限，
+        // 所以到过上限之后每次只取一个
+        if (multishot && !w->accept_oneshot) {
+            add_multishot_accept(w);
+        } else {
+            add_accept_request(w);
+        }
+    }
+}
+
+// 超过上限时已经 accept 进来的连接 (取消 multishot accept 之前在途的) 直接关掉
+void close_accepted(Worker *w, int fd) {
+    if (fixed) {
+        struct io_uring_sqe *sqe = get_sqe(w);
+        io_uring_prep_close_direct(sqe, fd);
+        io_uring_sqe_set_data64(sqe, make_user_data(EVENT_CLOSE, 0, 0));
+    } else {
+        close(fd);
+    }
+}
+
+// 每秒一次：转动时间轮，关闭到期的空闲连接，然后重新挂定时器
+void add_tick(Worker *w) {
+    struct io_uring_sqe *sqe = get_sqe(w);
+    io_uring_prep_timeout(sqe, &w->tick_ts, 0, 0);
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_TICK, 0, 0));
+}
+
+void conn_pump(Worker *w, ConnContext *ctx);
+
+void wheel_tick(Worker *w) {
+    w->tick++;
+    ConnContext **slot = &w->wheel[w->tick % WHEEL_SLOTS];
+    ConnContext *ctx = *slot;
+    *slot = NULL;
+    while (ctx) {
+        ConnContext *next = ctx->wheel_next;
+        ctx->wheel_pprev = NULL;
+        unsigned expire = ctx->last_active + idle_timeout;
+        if ((int)(expire - w->tick) > 0) {
+            wheel_add(w, ctx, expire);
+        } else if (ctx->closing) {
+            wheel_add(w, ctx, w->tick + idle_timeout);  // 还在等在途请求返回
+        } else {
+            if (!quiet) printf("[%d] Idle timeout: FD %d\n", w->id, ctx->fd);
+            w->idle_closed++;
+            wheel_add(w, ctx, w->tick + idle_timeout);
+            conn_abort(w, ctx);
+            conn_pump(w, ctx);  // 没有在途请求时立即释放
+        }
+        ctx = next;
+    }
+}
+
+// 辅助函数：添加 Read 请求，读进输入环的空闲区
+// -r 时后面链一个 linked timeout：到期时 read 以 -ECANCELED 完成，连接按超时关闭
+void add_read_request(Worker *w, ConnContext *ctx) {
+    // read 和 timeout 必须在同一次提交里才能保持链接
+    if (read_timeout_ms && io_uring_sq_space_left(&w->ring) < 2) io_uring_submit(&w->ring);
+    struct io_uring_sqe *sqe = get_sqe(w);
+    if (fixed) {
+        // 缓冲区所在 slab 已注册，buf_index 就是 slab 号；fixed 读只能给一段连续内存
+        size_t len;
+        char *p = ring_write_span(&ctx->in, &len);
+        io_uring_prep_read_fixed(sqe, ctx->fd, p, len, 0, ctx->buf_id / QUEUE_DEPTH);
+    } else {
+        int n = ring_iov(&ctx->in, ctx->in_iov, 0);
+        io_uring_prep_readv(sqe, ctx->fd, ctx->in_iov, n, 0);
+    }
+    prep_conn_file(sqe);
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_READ, 0, ctx->id));
+    ctx->reading = 1;
+    if (read_timeout_ms) {
+        sqe->flags |= IOSQE_IO_LINK;
+        sqe = get_sqe(w);
+        io_uring_prep_link_timeout(sqe, &w->read_ts, 0);
+        io_uring_sqe_set_data64(sqe, make_user_data(EVENT_TIMEOUT, 0, ctx->id));
+    }
+}
+
+// 写出输出环里的待发送数据；短写由完成事件处理，剩下的下次再写
+void submit_write(Worker *w, ConnContext *ctx) {
+    struct io_uring_sqe *sqe = get_sqe(w);
+    if (fixed) {
+        size_t len;
+        char *p = ring_read_span(&ctx->out, &len);
+        if (len >= ZC_THRESHOLD) {
+            // 零拷贝发送：网卡直接从注册的缓冲区取数据，完成后另有一个 F_NOTIF 通知才能复用这段输出环
+            io_uring_prep_send_zc_fixed(sqe, ctx->fd, p, len, 0, 0, ctx->buf_id / QUEUE_DEPTH);
+        } else {
+            io_uring_prep_write_fixed(sqe, ctx->fd, p, len, 0, ctx->buf_id / QUEUE_DEPTH);
+        }
+    } else {
+        int n = ring_iov(&ctx->out, ctx->out_iov, 1);
+        io_uring_prep_writev(sqe, ctx->fd, ctx->out_iov, n, 0);
+    }
+    prep_conn_file(sqe);
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_WRITE, 0, ctx->id));
+    ctx->writing = 1;
+    ctx->zc_sent = 0;
+}
+
+// GET 响应的文件内容，每个连接同一时间只有一组文件请求在途
+// splice：等输出环里的响应头发完，文件 -> 管道 -> socket 两个 splice 链在一起，数据不进用户态
+// copy：像 read() + write() 一样读进输出环，由普通的写路径发出；-F 下就是 read_fixed + send_zc
+void submit_file_io(Worker *w, ConnContext *ctx) {
+    if (ctx->file_busy) return;
+    if (!splice_files) {
+        size_t len;
+        char *p = ring_write_span(&ctx->out, &len);
+        if (ctx->file_left == 0 || len == 0) return;
+        if (len > ctx->file_left) len = ctx->file_left;
+        struct io_uring_sqe *sqe = get_sqe(w);
+        if (fixed) {
+            io_uring_prep_read_fixed(sqe, ctx->file_fd, p, len, ctx->file_off, ctx->buf_id / QUEUE_DEPTH);
+        } else {
+            io_uring_prep_read(sqe, ctx->file_fd, p, len, ctx->file_off);
+        }
+        io_uring_sqe_set_data64(sqe, make_user_data(EVENT_FILE_READ, 0, ctx->id));
+        ctx->file_busy = 1;
+        return;
+    }
+
+    // 响应头必须先于文件内容到达对端
+    if (ctx->writing || ring_used(&ctx->out) > 0) return;
+    if (ctx->pipe_bytes > 0) {
+        // 上次 socket 短写，管道里还有剩余
+        struct io_uring_sqe *sqe = get_sqe(w);
+        io_uring_prep_splice(sqe, ctx->pipe_fds[0], -1, ctx->fd, -1, ctx->pipe_bytes, 0);
+        prep_conn_file(sqe);
+        io_uring_sqe_set_data64(sqe, make_user_data(EVENT_SPLICE_OUT, 0, ctx->id));
+        ctx->file_busy = 1;
+        return;
+    }
+    if (ctx->file_left == 0) return;
+    if (ctx->pipe_fds[0] < 0) {
+        if (pipe2(ctx->pipe_fds, O_CLOEXEC) < 0) {
+            ctx->pipe_fds[0] = ctx->pipe_fds[1] = -1;
+            conn_abort(w, ctx);
+            return;
+        }
+        fcntl(ctx->pipe_fds[1], F_SETPIPE_SZ, SPLICE_PIPE_SIZE);
+        ctx->pipe_size = fcntl(ctx->pipe_fds[1], F_GETPIPE_SZ);
+        if (ctx->pipe_size <= 0) ctx->pipe_size = 65536;
+    }
+    unsigned len = ctx->file_left < (size_t)ctx->pipe_size ? ctx->file_left : (unsigned)ctx->pipe_size;
+    // 两个 SQE 必须在同一次提交里才能保持链接
+    if (io_uring_sq_space_left(&w->ring) < 2) io_uring_submit(&w->ring);
+    struct io_uring_sqe *sqe = get_sqe(w);
+    io_uring_prep_splice(sqe, ctx->file_fd, ctx->file_off, ctx->pipe_fds[1], -1, len, 0);
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_SPLICE_IN, 0, ctx->id));
+    sqe->flags |= IOSQE_IO_LINK;
+    // 前一个短读时链断开，这个 splice 以 -ECANCELED 完成，管道里的数据走上面的续写分支
+    sqe = get_sqe(w);
+    io_uring_prep_splice(sqe, ctx->pipe_fds[0], -1, ctx->fd, -1, len, 0);
+    prep_conn_file(sqe);
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_SPLICE_OUT, 0, ctx->id));
+    ctx->file_busy = 2;
+}
+
+void add_multishot_recv(Worker *w, ConnContext *ctx);
+size_t drain_pending(Worker *w, ConnContext *ctx);
+
+// 连接状态机：每个读/写完成后调用一次
+// 1. 解析输入，响应追加到输出环  2. 没有在途写就把输出环发出去
+// 3. 输入环有空间就保持一个读在途  4. 读写都结束且不再需要时释放
+void conn_pump(Worker *w, ConnContext *ctx) {
+    while (!ctx->closing) {
+        size_t moved = multishot ? drain_pending(w, ctx) : 0;
+        int n = conn_process(ctx);
+        if (n < 0) {
+            if (!quiet) fprintf(stderr, "[%d] protocol error on FD %d\n", w->id, ctx->fd);
+            conn_abort(w, ctx);
+            break;
+        }
+        w->requests += n;
+        if (n > 0) ctx->last_active = w->tick;
+        // 暂存的数据没拷完，但已经拷不动也解析不动了：等写完腾出空间
+        if (ctx->pend_head < 0 || (moved == 0 && n == 0)) break;
+    }
+
+    if (!ctx->closing) {
+        if (!ctx->writing && ring_used(&ctx->out) > 0) {
+            submit_write(w, ctx);
+        }
+        if (ctx->file_fd >= 0) {
+            submit_file_io(w, ctx);
+        }
+        if (multishot) {
+            if (ctx->recv_paused && ctx->pend_head < 0) {
+                ctx->recv_paused = 0;
+                add_multishot_recv(w, ctx);
+            }
+        } else if (ctx->linearize_wait && ctx->reading) {
+            // 对端可能已经把数据发完在等响应，不能干等这个 read 自己完成
+            if (!ctx->read_cancelling) {
+                struct io_uring_sqe *sqe = get_sqe(w);
+                io_uring_prep_cancel64(sqe, make_user_data(EVENT_READ, 0, ctx->id), 0);
+                io_uring_sqe_set_data64(sqe, make_user_data(EVENT_CLOSE, 0, 0));
+                ctx->read_cancelling = 1;
+            }
+        } else if (!ctx->reading && !ctx->eof && ring_free(&ctx->in) > 0) {
+            add_read_request(w, ctx);
+        }
     }
 
-    // 2. 创建监听 Socket
-    server_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (!ctx->reading && !ctx->writing && !ctx->file_busy &&
+        (ctx->closing || (ctx->eof && ring_used(&ctx->out) == 0 && ctx->pend_head < 0 && !conn_file_pending(ctx)))) {
+        conn_free(w, ctx);
+    }
+}
+
+void handle_file(Worker *w, ConnContext *ctx, int op, int res) {
+    ctx->file_busy--;
+    if (op == EVENT_SPLICE_OUT) {
+        if (res > 0) {
+            ctx->pipe_bytes -= res;
+            w->file_bytes += res;
+        } else if (res != -ECANCELED) {
+            conn_abort(w, ctx);
+        }
+    } else if (res > 0) {
+        if (op == EVENT_FILE_READ) {
+            ctx->out.tail += res;
+            w->file_bytes += res;
+        } else {
+            ctx->pipe_bytes += res;
+        }
+        ctx->file_off += res;
+        ctx->file_left -= res;
+        ctx->last_active = w->tick;
+    } else {
+        // 响应头里的长度已经发出去了，文件读不出来 (例如被截短) 只能断开连接
+        conn_abort(w, ctx);
+    }
+    if (ctx->file_left == 0 && ctx->pipe_bytes == 0) ctx->file_fd = -1;
+    if (ctx->file_busy == 0) conn_pump(w, ctx);
+}
+
+void handle_write(Worker *w, ConnContext *ctx, struct io_uring_cqe *cqe) {
+    // send_zc 会产生两个 CQE：第一个带 F_MORE 是发送结果，第二个带 F_NOTIF 表示缓冲区可以复用
+    int failed = 0;
+    if (!(cqe->flags & IORING_CQE_F_NOTIF)) {
+        failed = cqe->res < 0;
+        ctx->zc_sent = failed ? 0 : cqe->res;
+        if (cqe->flags & IORING_CQE_F_MORE) {
+            if (failed) conn_abort(w, ctx);  // F_NOTIF 还没到，连接不会在这期间被释放
+            return;
+        }
+    }
+    // 短写时 head 只前进实际写出的部分，剩下的由 conn_pump 续写
+    if (!ctx->closing) ctx->out.head += ctx->zc_sent;
+    ctx->writing = 0;
+    if (failed) {
+        conn_abort(w, ctx);
+    } else if (ctx->zc_sent > 0) {
+        ctx->last_active = w->tick;
+    }
+    conn_pump(w, ctx);
+}
+
+// legacy 模式：每次 accept 之后重新提交 accept，读写各自完成后交给状态机决定下一步
+void handle_legacy_cqe(Worker *w, struct io_uring_cqe *cqe) {
+    __u64 ud = io_uring_cqe_get_data64(cqe);
+
+    switch (UD_OP(ud)) {
+        case EVENT_ACCEPT: {
+            int client_fd = cqe->res;
+            if (client_fd >= 0) {
+                ConnContext *ctx = conn_alloc(w, client_fd);
+                if (ctx) {
+                    if (!quiet) printf("[%d] New connection: FD %d\n", w->id, client_fd);
+                    // 为新连接添加读请求
+                    add_read_request(w, ctx);
+                } else {
+                    close_accepted(w, client_fd);  // 超过连接数上限
+                }
+            } else {
+                fprintf(stderr, "Accept failed: %s\n", strerror(-cqe->res));
+            }
+            // 没到上限就重新添加 Accept 请求以接受下一个连接
+            w->accept_armed = 0;
+            accept_update(w);
+            break;
+        }
+        case EVENT_READ: {
+            ConnContext *ctx = conn_get(w, ud);
+            int cancelled = ctx->read_cancelling;
+            ctx->reading = 0;
+            ctx->read_cancelling = 0;
+            if (cqe->res > 0) {
+                // 取消没赶上也没关系：线性化还没做，数据落在正确的位置
+                ctx->in.tail += cqe->res;
+            } else if (cqe->res == 0) {
+                ctx->eof = 1;
+            } else if (cqe->res == -ECANCELED && cancelled) {
+                // 为了线性化取消的，conn_pump 旋转输入环之后重新挂 read
+            } else {
+                // -ECANCELED：linked timeout 先到期
+                if (cqe->res == -ECANCELED && !ctx->closing) {
+                    w->read_timeouts++;
+                    if (!quiet) printf("[%d] Read timeout: FD %d\n", w->id, ctx->fd);
+                }
+                conn_abort(w, ctx);
+            }
+            conn_pump(w, ctx);
+            break;
+        }
+        case EVENT_WRITE:
+            handle_write(w, conn_get(w, ud), cqe);
+            break;
+        case EVENT_FILE_READ:
+        case EVENT_SPLICE_IN:
+        case EVENT_SPLICE_OUT:
+            handle_file(w, conn_get(w, ud), UD_OP(ud), cqe->res);
+            break;
+        case EVENT_TICK:
+            wheel_tick(w);
+            add_tick(w);
+            break;
+        case EVENT_TIMEOUT:
+        case EVENT_CLOSE:
+            break;
+    }
+}
+
+int start_legacy(Worker *w) {
+    // 提交第一个 Accept 请求
+    add_accept_request(w);
+    return 0;
+}
+
+// ---------------------- multishot 模式 ----------------------
+// 一个 multishot accept SQE 服务整个监听过程，每个连接一个 multishot recv SQE 服务整个连接生命周期
+// 接收缓冲区来自内核管理的 buffer ring：recv 完成时内核挑一块空闲缓冲区，CQE 里带回 buffer id
+// 数据拷进连接的输入环后缓冲区立即还给 ring；输入环满时先挂在连接上，腾出空间再拷
+
+static char *buf_addr(Worker *w, unsigned short bid) {
+    return w->buf_base + (size_t)bid * buf_size;
+}
+
+int setup_buffer_ring(Worker *w) {
+    int ret;
+    // 总内存固定为 BUF_RING_BYTES，缓冲区越大个数越少
+    w->buf_entries = BUF_RING_ENTRIES;
+    while (w->buf_entries > 16 && (size_t)w->buf_entries * buf_size > BUF_RING_BYTES) {
+        w->buf_entries >>= 1;
+    }
+    w->buf_ring = io_uring_setup_buf_ring(&w->ring, w->buf_entries, BUF_GROUP_ID, 0, &ret);
+    if (!w->buf_ring) {
+        fprintf(stderr, "io_uring_setup_buf_ring: %s (kernel >= 5.19 required)\n", strerror(-ret));
+        return -1;
+    }
+    w->buf_base = malloc((size_t)w->buf_entries * buf_size);
+    w->buf_next = malloc(sizeof(int) * w->buf_entries);
+    w->buf_off = malloc(sizeof(unsigned) * w->buf_entries);
+    w->buf_len = malloc(sizeof(unsigned) * w->buf_entries);
+    if (!w->buf_base || !w->buf_next || !w->buf_off || !w->buf_len) {
+        perror("malloc");
+        return -1;
+    }
+    int mask = io_uring_buf_ring_mask(w->buf_entries);
+    for (unsigned i = 0; i < w->buf_entries; i++) {
+        io_uring_buf_ring_add(w->buf_ring, buf_addr(w, i), buf_size, i, mask, i);
+    }
+    io_uring_buf_ring_advance(w->buf_ring, w->buf_entries);
+    return 0;
+}
+
+void add_multishot_accept(Worker *w) {
+    struct io_uring_sqe *sqe = get_sqe(w);
+    if (fixed) {
+        io_uring_prep_multishot_accept_direct(sqe, w->listen_socket, NULL, NULL, 0);
+    } else {
+        io_uring_prep_multishot_accept(sqe, w->listen_socket, NULL, NULL, 0);
+    }
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_ACCEPT, 0, 0));
+    w->accept_armed = 1;
+}
+
+void add_multishot_recv(Worker *w, ConnContext *ctx) {
+    struct io_uring_sqe *sqe = get_sqe(w);
+    // buf 传 NULL：由内核从 BUF_GROUP_ID 里挑缓冲区
+    io_uring_prep_recv_multishot(sqe, ctx->fd, NULL, 0, 0);
+    io_uring_sqe_set_flags(sqe, IOSQE_BUFFER_SELECT);
+    prep_conn_file(sqe);
+    sqe->buf_group = BUF_GROUP_ID;
+    io_uring_sqe_set_data64(sqe, make_user_data(EVENT_READ, 0, ctx->id));
+    ctx->reading = 1;
+}
+
+// 缓冲区还给 ring；如果有连接因缺缓冲区停了 recv，顺便把它重新挂上
+void recycle_buffer(Worker *w, unsigned short bid) {
+    io_uring_buf_ring_add(w->buf_ring, buf_addr(w, bid), buf_size, bid, io_uring_buf_ring_mask(w->buf_entries), 0);
+    io_uring_buf_ring_advance(w->buf_ring, 1);
+
+    ConnContext *ctx = w->starved_head;
+    if (ctx) {
+        w->starved_head = ctx->next_starved;
+        ctx->starved = 0;
+        add_multishot_recv(w, ctx);
+    }
+}
+
+// 把暂存的 provided buffer 按顺序拷进输入环，拷完的缓冲区还给 ring，返回拷入的字节数
+size_t drain_pending(Worker *w, ConnContext *ctx) {
+    size_t moved = 0;
+    while (ctx->pend_head >= 0) {
+        unsigned short bid = ctx->pend_head;
+        size_t n = ring_write(&ctx->in, buf_addr(w, bid) + w->buf_off[bid], w->buf_len[bid]);
+        moved += n;
+        w->buf_off[bid] += n;
+        w->buf_len[bid] -= n;
+        if (w->buf_len[bid] > 0) break;  // 输入环满了
+        ctx->pend_head = w->buf_next[bid];
+        if (ctx->pend_head < 0) ctx->pend_tail = -1;
+        recycle_buffer(w, bid);
+    }
+    return moved;
+}
+
+void handle_recv(Worker *w, ConnContext *ctx, struct io_uring_cqe *cqe) {
+    int res = cqe->res;
+    int more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (res > 0) {
+        // 先挂到暂存链表尾部，保证和之前没拷完的数据保持顺序
+        unsigned short bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        w->buf_off[bid] = 0;
+        w->buf_len[bid] = res;
+        w->buf_next[bid] = -1;
+        if (ctx->pend_tail >= 0) {
+            w->buf_next[ctx->pend_tail] = bid;
+        } else {
+            ctx->pend_head = bid;
+        }
+        ctx->pend_tail = bid;
+    }
+    if (!more) {
+        // multishot 结束：对端关闭 / 出错时关连接；缓冲区耗尽或内核主动终止则重新挂上
+        if (res > 0 && !ctx->closing) {
+            add_multishot_recv(w, ctx);
+        } else if (res == -ENOBUFS && !ctx->closing) {
+            if (ctx->pend_head >= 0) {
+                // 自己手里还压着缓冲区，先消化掉再挂 recv，不和其他连接抢
+                ctx->reading = 0;
+                ctx->recv_paused = 1;
+            } else {
+                ctx->starved = 1;  // 仍算作 reading
+                ctx->next_starved = w->starved_head;
+                w->starved_head = ctx;
+            }
+        } else {
+            ctx->reading = 0;
+            if (res == 0) {
+                ctx->eof = 1;
+            } else if (res < 0 && res != -ENOBUFS) {
+                conn_abort(w, ctx);
+            }
+        }
+    }
+    conn_pump(w, ctx);
+}
+
+void handle_multishot_cqe(Worker *w, struct io_uring_cqe *cqe) {
+    __u64 ud = io_uring_cqe_get_data64(cqe);
+    switch (UD_OP(ud)) {
+        case EVENT_ACCEPT: {
+            if (cqe->res >= 0) {
+                ConnContext *ctx = conn_alloc(w, cqe->res);
+                if (ctx) {
+                    if (!quiet) printf("[%d] New connection: FD %d\n", w->id, cqe->res);
+                    add_multishot_recv(w, ctx);
+                } else {
+                    close_accepted(w, cqe->res);  // 超过连接数上限
+                }
+            } else if (cqe->res != -ECANCELED) {
+                fprintf(stderr, "Accept failed: %s\n", strerror(-cqe->res));
+            }
+            // 没有 F_MORE 说明 multishot accept 被终止 (fd 用尽，或到上限时被我们取消)，没到上限就重新提交
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                w->accept_armed = 0;
+                w->accept_cancelling = 0;
+            }
+            accept_update(w);
+            break;
+        }
+        case EVENT_READ:
+            handle_recv(w, conn_get(w, ud), cqe);
+            break;
+        case EVENT_WRITE:
+            handle_write(w, conn_get(w, ud), cqe);
+            break;
+        case EVENT_FILE_READ:
+        case EVENT_SPLICE_IN:
+        case EVENT_SPLICE_OUT:
+            handle_file(w, conn_get(w, ud), UD_OP(ud), cqe->res);
+            break;
+        case EVENT_TICK:
+            wheel_tick(w);
+            add_tick(w);
+            break;
+        case EVENT_TIMEOUT:
+        case EVENT_CLOSE:
+            break;
+    }
+}
+
+int start_multishot(Worker *w) {
+    if (setup_buffer_ring(w) < 0) {
+        return -1;
+    }
+    add_multishot_accept(w);
+    return 0;
+}
+
+// ---------------------- 事件循环 ----------------------
+
+// 逐个处理：每个 CQE 一次 wait，处理完立即 submit
+void run_single(Worker *w, cqe_handler handle) {
+    struct io_uring_cqe *cqe;
+    io_uring_submit(&w->ring);
+    while (!stop) {
+        int ret = io_uring_wait_cqe(&w->ring, &cqe);
+        if (ret < 0) {
+            if (ret == -EINTR) continue;
+            fprintf(stderr, "io_uring_wait_cqe: %s\n", strerror(-ret));
+            break;
+        }
+        w->loop_iterations++;
+        w->cqes_reaped++;
+
+        handle(w, cqe);
+
+        // 标记 CQE 已处理
+        io_uring_cqe_seen(&w->ring, cqe);
+
+        // 提交所有新生成的 SQE；CQ 溢出时 liburing 会顺带进内核把溢出的 CQE 搬回 CQ
+        if (io_uring_cq_has_overflow(&w->ring)) w->cq_overflows++;
+        io_uring_submit(&w->ring);
+    }
+}
+
+// 批量处理：一次 submit_and_wait 同时完成 "提交上一轮产生的所有 SQE" 和 "等待至少一个 CQE"
+// 然后把 CQ 里已有的完成事件全部处理完，最后一次性推进 CQ head
+void run_batched(Worker *w, cqe_handler handle) {
+    struct io_uring_cqe *cqe;
+    while (!stop) {
+        // CQ 里已经有完成事件时不必等待；SQPOLL 下 io_uring_submit 通常不进内核
+        int ret = io_uring_cq_ready(&w->ring) ? io_uring_submit(&w->ring) : io_uring_submit_and_wait(&w->ring, 1);
+        if (ret < 0) {
+            // -EBUSY：老内核在 CQ 溢出积压时拒绝提交，先把 CQ 里的处理掉再重试
+            if (ret == -EINTR || (ret == -EBUSY && io_uring_cq_ready(&w->ring))) continue;
+            fprintf(stderr, "io_uring_submit_and_wait: %s\n", strerror(-ret));
+            break;
+        }
+        w->loop_iterations++;
+
+        unsigned head;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&w->ring, head, cqe) {
+            handle(w, cqe);
+            count++;
+        }
+        w->cqes_reaped += count;
+
+        // 标记这批 CQE 已处理，推进内核队列指针
+        io_uring_cq_advance(&w->ring, count);
+        // CQ 满时内核把多出来的 CQE 挂在溢出链表上 (IORING_FEAT_NODROP)，下次进内核时搬回来
+        if (io_uring_cq_has_overflow(&w->ring)) w->cq_overflows++;
+    }
+}
+
+// ---------------------- ring 初始化 ----------------------
+
+// 可选的 setup 标志，内核不认识时按这个顺序逐个去掉重试
+// DEFER_TASKRUN 依赖 SINGLE_ISSUER，SQ_AFF 依赖 SQPOLL，所以被依赖的排在后面
+static const struct {
+    unsigned flag;
+    const char *name;
+} optional_flags[] = {
+    { IORING_SETUP_DEFER_TASKRUN, "DEFER_TASKRUN" },
+    { IORING_SETUP_SINGLE_ISSUER, "SINGLE_ISSUER" },
+    { IORING_SETUP_SQ_AFF, "SQ_AFF" },
+    { IORING_SETUP_SQPOLL, "SQPOLL" },
+};
+
+int setup_ring(Worker *w) {
+    unsigned flags = ring_flags;
+    size_t next = 0;
+    for (;;) {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        params.flags = flags | IORING_SETUP_CQSIZE;
+        params.cq_entries = CQ_ENTRIES;
+        if (flags & IORING_SETUP_SQPOLL) {
+            params.sq_thread_idle = sq_idle_ms;
+        }
+        if (flags & IORING_SETUP_SQ_AFF) {
+            params.sq_thread_cpu = (sq_cpu + w->id) % sysconf(_SC_NPROCESSORS_ONLN);
+        }
+
+        int ret = io_uring_queue_init_params(QUEUE_DEPTH, &w->ring, &params);
+        if (ret == 0) {
+            if (!(params.features & IORING_FEAT_NODROP)) {
+                fprintf(stderr, "[%d] kernel lacks IORING_FEAT_NODROP, completions are lost if the CQ overflows\n", w->id);
+            }
+            return 0;
+        }
+        // 老内核对不认识的标志返回 -EINVAL；5.11 之前非 root 用 SQPOLL 返回 -EPERM
+        if (ret != -EINVAL && ret != -EPERM) {
+            fprintf(stderr, "io_uring_queue_init_params: %s\n", strerror(-ret));
+            return ret;
+        }
+        while (next < sizeof(optional_flags) / sizeof(optional_flags[0]) && !(flags & optional_flags[next].flag)) {
+            next++;
+        }
+        if (next == sizeof(optional_flags) / sizeof(optional_flags[0])) {
+            fprintf(stderr, "io_uring_queue_init_params: %s\n", strerror(-ret));
+            return ret;
+        }
+        fprintf(stderr, "[%d] kernel rejected IORING_SETUP_%s (%s), retrying without it\n",
+                w->id, optional_flags[next].name, strerror(-ret));
+        flags &= ~optional_flags[next].flag;
+        if (optional_flags[next].flag == IORING_SETUP_SQPOLL) flags &= ~IORING_SETUP_SQ_AFF;
+    }
+}
+
+// ---------------------- 线程与监听 socket ----------------------
+
+// 每个 worker 一个监听 socket，SO_REUSEPORT 让内核把新连接分散到各个 socket 上
+int create_listener(void) {
+    struct sockaddr_in server_addr;
+    int server_socket = socket(AF_INET, SOCK_STREAM, 0);
     if (server_socket < 0) {
         perror("Socket creation failed");
-        return 1;
+        return -1;
     }
 
-    int opt = 1;
-    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    int on = 1;
+    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    // 由 accept 出来的连接继承 (direct descriptor 没法再单独 setsockopt)
+    // 输出环一次装不下整批流水线响应时会分几次写，开着 Nagle 会和对端的延迟 ACK 互相等 40ms
+    setsockopt(server_socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
 
+    memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(PORT);
 
     if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
         perror("Bind failed");
-        return 1;
+        close(server_socket);
+        return -1;
     }
 
-    if (listen(server_socket, 10) < 0) {
+    // 几千个连接同时 connect 时 backlog 太小会被丢 SYN
+    if (listen(server_socket, BACKLOG) < 0) {
         perror("Listen failed");
-        return 1;
+        close(server_socket);
+        return -1;
     }
+    return server_socket;
+}
 
-    printf("Server listening on port %d using io_uring...\n", PORT);
+void *worker_main(void *arg) {
+    Worker *w = arg;
 
-    // 3. 提交第一个 Accept 请求
-    add_accept_request(server_socket, &client_addr, &client_len);
-    io_uring_submit(&ring);
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err) fprintf(stderr, "[%d] pthread_setaffinity_np: %s\n", w->id, strerror(err));
+    }
 
-    // 4. 事件循环
-    struct io_uring_cqe *cqe;
-    while (1) {
-        int ret = io_uring_wait_cqe(&ring, &cqe);
-        if (ret < 0) {
-            perror("io_uring_wait_cqe");
-            break;
-        }
+    // ring 在本线程里创建：内存分配落在本线程所在的 NUMA 节点，SINGLE_ISSUER 也要求由创建者提交
+    if (setup_ring(w) < 0) {
+        kill(getpid(), SIGTERM);  // 任何一个 worker 起不来就整体退出
+        return NULL;
+    }
+    pool_init(&w->conn_pool, sizeof(ConnContext));
+    pool_init(&w->buf_pool, 2 * buf_size);  // 输入环 + 输出环
+    if (fixed && setup_fixed(w) < 0) {
+        kill(getpid(), SIGTERM);
+        io_uring_queue_exit(&w->ring);
+        return NULL;
+    }
 
-        Request *req = (Request *)io_uring_cqe_get_data(cqe);
-        
-        // 检查操作结果 (res 字段)
-        if (cqe->res < 0) {
-            fprintf(stderr, "Async request failed: %s\n", strerror(-cqe->res));
-        }
+    w->read_ts.tv_sec = read_timeout_ms / 1000;
+    w->read_ts.tv_nsec = (read_timeout_ms % 1000) * 1000000L;
+    w->tick_ts.tv_sec = 1;
+    if (idle_timeout) add_tick(w);
 
-        switch (req->event_type) {
-            case EVENT_ACCEPT: {
-                int client_fd = cqe->res;
-                if (client_fd >= 0) {
-                    printf("New connection: FD %d\n", client_fd);
-                    // 为新连接添加读请求
-                    add_read_request(client_fd);
+    // 提交第一批请求，进入事件循环
+    cqe_handler handle = multishot ? handle_multishot_cqe : handle_legacy_cqe;
+    int ret = multishot ? start_multishot(w) : start_legacy(w);
+    if (ret < 0) {
+        kill(getpid(), SIGTERM);
+    } else if (batch) {
+        run_batched(w, handle);
+    } else {
+        run_single(w, handle);
+    }
+
+    file_cache_close();
+    w->cq_dropped = *w->ring.cq.koverflow;
+    io_uring_queue_exit(&w->ring);
+    return NULL;
+}
+
+// 只用来打断 worker 阻塞中的 io_uring_enter
+void handle_wakeup(int sig) {
+    (void)sig;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-m legacy|multishot] [-b] [-t threads] [-P] [-F] [-B bytes] [-S] [-i ms] [-C cpu] [-e] [-p echo|line|get|frame] [-g splice|copy] [-D dir]\n"
+                    "          [-c max connections] [-I idle seconds] [-r read timeout ms] [-q]\n", prog);
+    fprintf(stderr, "  -m  legacy: accept/readv/writev, one-shot requests (default)\n");
+    fprintf(stderr, "      multishot: multishot accept + multishot recv with provided buffer ring\n");
+    fprintf(stderr, "  -b  batched loop: reap all CQEs, then one io_uring_submit_and_wait per iteration\n");
+    fprintf(stderr, "  -t  worker threads, one ring and one SO_REUSEPORT listener each (default 1)\n");
+    fprintf(stderr, "  -P  don't pin worker threads to CPUs\n");
+    fprintf(stderr, "  -F  registered files (direct accept) and registered buffers:\n");
+    fprintf(stderr, "      read_fixed/write_fixed on the connection buffers, send_zc for writes >= %d bytes\n", ZC_THRESHOLD);
+    fprintf(stderr, "  -B  per-connection input/output buffer size in bytes (default %d)\n", BUF_SIZE);
+    fprintf(stderr, "  -S  SQPOLL: a kernel thread polls the SQ, no submit syscalls while it is awake\n");
+    fprintf(stderr, "  -i  SQPOLL idle time in ms before the SQ thread sleeps (default: kernel, 1000)\n");
+    fprintf(stderr, "  -C  pin the SQ thread of worker N to CPU (cpu + N)\n");
+    fprintf(stderr, "  -e  IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN (not with -S)\n");
+    fprintf(stderr, "      flags the kernel rejects are dropped with a warning\n");
+    fprintf(stderr, "  -p  protocol: echo (default), line: one response per '\\n'-terminated request,\n");
+    fprintf(stderr, "      get: \"GET <path>\\n\" answered with \"OK <size>\\n\" + file content, or \"ERR <errno>\\n\"\n");
+    fprintf(stderr, "      frame: length-prefixed frames (frame.h) dispatched by type, MSG_ECHO / MSG_PING\n");
+    fprintf(stderr, "  -g  how get sends file content: splice (default, file -> pipe -> socket)\n");
+    fprintf(stderr, "      or copy (read into the output buffer, then write; read_fixed/send_zc with -F)\n");
+    fprintf(stderr, "  -D  document root for get (default: current directory), open fds and sizes are cached\n");
+    fprintf(stderr, "  -c  max connections over all workers, accept pauses at the limit\n");
+    fprintf(stderr, "      (default: RLIMIT_NOFILE minus %d reserved fds per worker)\n", FD_RESERVE);
+    fprintf(stderr, "  -I  close connections that completed no request and sent nothing for this many\n");
+    fprintf(stderr, "      seconds, checked by a 1s timer wheel (default %u, 0 disables)\n", idle_timeout);
+    fprintf(stderr, "  -r  legacy mode: linked timeout on every read, close the connection when a read\n");
+    fprintf(stderr, "      waits longer than this many ms (default 0, disabled)\n");
+    fprintf(stderr, "  -q  quiet, don't log every connection\n");
+}
+
+int main(int argc, char *argv[]) {
+    int threads = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:bt:PFB:Si:C:ep:g:D:c:I:r:qh")) != -1) {
+        switch (opt) {
+            case 'm':
+                if (strcmp(optarg, "multishot") == 0) {
+                    multishot = 1;
+                } else if (strcmp(optarg, "legacy") != 0) {
+                    usage(argv[0]);
+                    return 1;
                 }
-                // 重新添加 Accept 请求以接受下一个连接
-                add_accept_request(server_socket, &client_addr, &client_len);
-                free(req); // Accept 的 req 不需要保持，可以释放
                 break;
-            }
-            case EVENT_READ: {
-                int bytes_read = cqe->res;
-                if (bytes_read <= 0) {
-                    // 连接关闭或出错
-                    printf("Connection closed: FD %d\n", req->fd);
-                    close(req->fd);
-                    free(req);
-                } else {
-                    // 读到了数据，添加写请求 (回显)
-                    // 注意：这里为了演示简单，创建了新的 Write Request
-                    // 实际高性能场景可以复用结构体
-                    add_write_request(req->fd, req->buffer, bytes_read);
-                    free(req); // 读请求完成，释放资源
+            case 'b':
+                batch = 1;
+                break;
+            case 't':
+                threads = atoi(optarg);
+                break;
+            case 'P':
+                pin_cpu = 0;
+                break;
+            case 'F':
+                fixed = 1;
+                break;
+            case 'B':
+                buf_size = strtoul(optarg, NULL, 10);
+                break;
+            case 'S':
+                ring_flags |= IORING_SETUP_SQPOLL;
+                break;
+            case 'i':
+                sq_idle_ms = strtoul(optarg, NULL, 10);
+                break;
+            case 'C':
+                sq_cpu = atoi(optarg);
+                break;
+            case 'e':
+                ring_flags |= IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+                break;
+            case 'p':
+                if (strcmp(optarg, "line") == 0) {
+                    protocol = proto_line;
+                } else if (strcmp(optarg, "get") == 0) {
+                    protocol = proto_get;
+                } else if (strcmp(optarg, "frame") == 0) {
+                    protocol = proto_frame;
+                } else if (strcmp(optarg, "echo") != 0) {
+                    usage(argv[0]);
+                    return 1;
                 }
                 break;
-            }
-            case EVENT_WRITE: {
-                // 写操作完成
-                // 继续监听该 FD 的读事件
-                add_read_request(req->fd);
-                free(req); // 写请求完成，释放资源
+            case 'g':
+                if (strcmp(optarg, "copy") == 0) {
+                    splice_files = 0;
+                } else if (strcmp(optarg, "splice") != 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
                 break;
-            }
+            case 'D':
+                doc_root = optarg;
+                break;
+            case 'c':
+                max_conns = strtoul(optarg, NULL, 10);
+                break;
+            case 'I':
+                idle_timeout = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                read_timeout_ms = strtoul(optarg, NULL, 10);
+                break;
+            case 'q':
+                quiet = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (sq_cpu >= 0) {
+        if (ring_flags & IORING_SETUP_SQPOLL) {
+            ring_flags |= IORING_SETUP_SQ_AFF;
+        } else {
+            fprintf(stderr, "-C only applies to SQPOLL (-S), ignored\n");
         }
+    }
+    if ((ring_flags & IORING_SETUP_SQPOLL) && (ring_flags & IORING_SETUP_DEFER_TASKRUN)) {
+        // DEFER_TASKRUN 要求完成事件在提交者线程里跑，和内核 SQ 线程互斥
+        fprintf(stderr, "DEFER_TASKRUN can't be combined with SQPOLL, using SINGLE_ISSUER only\n");
+        ring_flags &= ~IORING_SETUP_DEFER_TASKRUN;
+    }
+    if (buf_size == 0 || buf_size > (1u << 30)) {
+        fprintf(stderr, "invalid buffer size\n");
+        return 1;
+    }
+    if (threads < 1 || threads > MAX_THREADS) {
+        fprintf(stderr, "threads must be in [1, %d]\n", MAX_THREADS);
+        return 1;
+    }
 
-        // 标记 CQE 已处理
-        io_uring_cqe_seen(&ring, cqe);
-        
-        // 提交所有新生成的 SQE
-        io_uring_submit(&ring);
+    setup_rlimit();
+    if (read_timeout_ms && multishot) {
+        // multishot recv 常驻整个连接生命周期，linked timeout 会把它整个取消；这种模式只靠时间轮
+        fprintf(stderr, "-r only applies to legacy mode, multishot relies on the idle timer (-I)\n");
+        read_timeout_ms = 0;
+    }
+    // 连接数上限：fd 上限扣掉每个 worker 的预留，再平分给各个 worker
+    struct rlimit nofile;
+    getrlimit(RLIMIT_NOFILE, &nofile);
+    unsigned fd_limit = nofile.rlim_cur > (rlim_t)FD_RESERVE * threads ? nofile.rlim_cur - FD_RESERVE * threads : threads;
+    if (max_conns == 0 || max_conns > fd_limit) max_conns = fd_limit;
+    unsigned per_worker = (max_conns + threads - 1) / threads;
+    if (per_worker > MAX_CONNECTIONS) per_worker = MAX_CONNECTIONS;
+
+    // SIGINT / SIGTERM 只由主线程 sigwait 接收；worker 靠 SIGUSR1 打断阻塞的 io_uring_enter
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_wakeup;  // 不设 SA_RESTART，io_uring_enter 返回 -EINTR
+    sigaction(SIGUSR1, &sa, NULL);
+
+    // 1. 每个 worker 一个监听 socket，全部 bind 成功再启动线程
+    Worker *workers = calloc(threads, sizeof(Worker));
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 0; i < threads; i++) {
+        workers[i].id = i;
+        workers[i].cpu = pin_cpu ? (int)(i % ncpu) : -1;
+        workers[i].max_conns = per_worker;
+        workers[i].listen_socket = create_listener();
+        if (workers[i].listen_socket < 0) return 1;
     }
 
-    io_uring_queue_exit(&ring);
-    close(server_socket);
+    printf("Server listening on port %d using io_uring (%s, %s, %s loop, %d thread%s%s%s%s)...\n", PORT,
+           protocol == proto_line ? "line" : protocol == proto_get ? (splice_files ? "get/splice" : "get/copy") : protocol == proto_frame ? "frame" : "echo", multishot ? "multishot" : "legacy", batch ? "batched" : "single", threads, threads > 1 ? "s" : "",
+           fixed ? ", fixed files/buffers" : "", (ring_flags & IORING_SETUP_SQPOLL) ? ", sqpoll" : "",
+           (ring_flags & IORING_SETUP_SINGLE_ISSUER) ? ", single issuer" : "");
+    printf("Max connections: %u per worker, idle timeout: %us, read timeout: %ums\n", per_worker, idle_timeout, read_timeout_ms);
+
+    // 2. 启动 worker，每个线程一个 ring
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    // 3. 等待退出信号，然后逐个唤醒 worker 直到它们退出
+    int sig;
+    sigwait(&set, &sig);
+    stop = 1;
+    for (int i = 0; i < threads; i++) {
+        while (pthread_tryjoin_np(workers[i].thread, NULL) == EBUSY) {
+            pthread_kill(workers[i].thread, SIGUSR1);
+            usleep(10000);
+        }
+    }
+
+    long requests = 0, allocations = 0, iterations = 0, cqes = 0, file_bytes = 0;
+    long read_timeouts = 0, idle_closed = 0, accept_pauses = 0, cq_overflows = 0, cq_dropped = 0;
+    for (int i = 0; i < threads; i++) {
+        Worker *w = &workers[i];
+        requests += w->requests;
+        allocations += w->conn_pool.allocations + w->buf_pool.allocations;
+        iterations += w->loop_iterations;
+        cqes += w->cqes_reaped;
+        file_bytes += w->file_bytes;
+        read_timeouts += w->read_timeouts;
+        idle_closed += w->idle_closed;
+        accept_pauses += w->accept_pauses;
+        cq_overflows += w->cq_overflows;
+        cq_dropped += w->cq_dropped;
+        if (threads > 1) fprintf(stderr, "worker %d: requests %ld\n", i, w->requests);
+        close(w->listen_socket);
+    }
+
+    // 稳定运行时应为 0：只有并发连接数创新高时才会扩容 slab
+    fprintf(stderr, "requests: %ld, allocations: %ld (%.6f per request)\n",
+            requests, allocations, requests ? (double)allocations / requests : 0.0);
+    fprintf(stderr, "loop iterations: %ld, cqes per iteration: %.2f\n",
+            iterations, iterations ? (double)cqes / iterations : 0.0);
+    fprintf(stderr, "read timeouts: %ld, idle closed: %ld, accept pauses: %ld, cq overflows: %ld (dropped %ld)\n",
+            read_timeouts, idle_closed, accept_pauses, cq_overflows, cq_dropped);
+    if (protocol == proto_get) {
+        // 整个进程的 user + sys 时间，splice 模式下内核搬数据的开销也算在 sys 里
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        double cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+        double gb = file_bytes / 1e9;
+        fprintf(stderr, "file bytes: %.1f MB, cpu: %.2f s (user %.2f, sys %.2f), cpu per GB: %.3f s\n",
+                file_bytes / 1e6, cpu, ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6,
+                ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6, gb > 0 ? cpu / gb : 0.0);
+    }
+    free(workers);
     return 0;
 }
-
-// #include <stdio.h>
-// #include <stdlib.h>
-// #include <string.h>
-// #include <unistd.h>
-// #include <fcntl.h>
-// #include <sys/socket.h>
-// #include <sys/resource.h>
-// #include <netinet/in.h>
-// #include <netinet/tcp.h>
-// #include <liburing.h>
-
-// #define PORT 8080
-// #define MAX_CONNECTIONS 65536  // 最大连接数，需小于 ulimit -n
-// #define BACKLOG 4096
-// #define RING_DEPTH 8192        // io_uring 队列深度
-// #define BUF_SIZE 1024
-
-// // 定义操作类型
-// enum {
-//     OP_ACCEPT,
-//     OP_READ,
-//     OP_WRITE
-// };
-
-// // 连接上下文，预分配在全局数组中
-// typedef struct {
-//     int fd;
-//     int op;
-//     char buffer[BUF_SIZE];
-//     struct iovec iov;
-// } ConnContext;
-
-// // 预分配所有可能的连接上下文
-// // 简单的做法是直接用 FD 作为数组下标
-// ConnContext conns[MAX_CONNECTIONS];
-
-// struct io_uring ring;
-
-// // 设置非阻塞模式
-// void set_nonblocking(int fd) {
-//     int flags = fcntl(fd, F_GETFL, 0);
-//     fcntl(fd, F_SETFL, flags | O_NONBLOCK);
-// }
-
-// // 提升文件描述符限制
-// void setup_rlimit() {
-//     struct rlimit limit;
-//     if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
-//         perror("getrlimit");
-//         exit(1);
-//     }
-//     // 尝试提升到最大值
-//     limit.rlim_cur = MAX_CONNECTIONS;
-//     if (limit.rlim_cur > limit.rlim_max) limit.rlim_cur = limit.rlim_max;
-    
-//     if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
-//         perror("setrlimit failed (try running with sudo or ulimit -n 65536)");
-//         exit(1);
-//     }
-//     printf("Max open files set to: %lu\n", limit.rlim_cur);
-// }
-
-// // 提交 Accept 请求
-// void add_accept(int server_fd) {
-//     struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
-//     ConnContext *ctx = &conns[server_fd]; // 监听 socket 的上下文
-//     ctx->fd = server_fd;
-//     ctx->op = OP_ACCEPT;
-
-//     // accept 的第三、四个参数由内核填充，这里简单起见传 NULL
-//     // 如果需要客户端 IP，需传入全局的 sockaddr 缓存
-//     io_uring_prep_accept(sqe, server_fd, NULL, NULL, 0);
-//     io_uring_sqe_set_data(sqe, ctx);
-// }
-
-// // 提交 Read 请求
-// void add_read(int fd) {
-//     struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
-//     ConnContext *ctx = &conns[fd];
-//     ctx->fd = fd;
-//     ctx->op = OP_READ;
-//     ctx->iov.iov_base = ctx->buffer;
-//     ctx->iov.iov_len = BUF_SIZE;
-
-//     io_uring_prep_readv(sqe, fd, &ctx->iov, 1, 0);
-//     io_uring_sqe_set_data(sqe, ctx);
-// }
-
-// // 提交 Write 请求
-// void add_write(int fd, int bytes) {
-//     struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
-//     ConnContext *ctx = &conns[fd];
-//     ctx->fd = fd;
-//     ctx->op = OP_WRITE;
-//     ctx->iov.iov_len = bytes;
-
-//     io_uring_prep_writev(sqe, fd, &ctx->iov, 1, 0);
-//     io_uring_sqe_set_data(sqe, ctx);
-// }
-
-// int main() {
-//     setup_rlimit();
-
-//     // 1. 初始化 io_uring
-//     struct io_uring_params params;
-//     memset(&params, 0, sizeof(params));
-    
-//     // 如果内核支持 IORING_SETUP_SINGLE_ISSUER，可以启用以提升性能（可选）
-//     // params.flags |= IORING_SETUP_SINGLE_ISSUER;
-
-//     if (io_uring_queue_init_params(RING_DEPTH, &ring, &params) < 0) {
-//         perror("io_uring_queue_init");
-//         return 1;
-//     }
-
-//     // 2. 创建监听 Socket
-//     int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-//     if (server_fd < 0) {
-//         perror("Socket");
-//         return 1;
-//     }
-
-//     int opt = 1;
-//     setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-//     setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)); // 支持多进程/线程绑定同一端口
-    
-//     // 禁用 Nagle 算法，降低延迟
-//     setsockopt(server_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
-
-//     struct sockaddr_in addr;
-//     addr.sin_family = AF_INET;
-//     addr.sin_addr.s_addr = INADDR_ANY;
-//     addr.sin_port = htons(PORT);
-
-//     if (bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-//         perror("Bind");
-//         return 1;
-//     }
-
-//     if (listen(server_fd, BACKLOG) < 0) {
-//         perror("Listen");
-//         return 1;
-//     }
-
-//     // 3. 初始提交 Accept
-//     add_accept(server_fd);
-
-//     printf("High-Performance Server listening on %d. Ring depth: %d\n", PORT, RING_DEPTH);
-
-//     // 4. 事件循环
-//     struct io_uring_cqe *cqe;
-//     while (1) {
-//         // 提交所有待处理的 SQE，并等待至少 1 个 CQE 完成
-//         int ret = io_uring_submit_and_wait(&ring, 1);
-//         if (ret < 0) {
-//             perror("submit_and_wait");
-//             break;
-//         }
-
-//         // 批量处理所有已完成的事件（CQ 队列中的事件）
-//         unsigned head;
-//         unsigned count = 0;
-
-//         io_uring_for_each_cqe(&ring, head, cqe) {
-//             count++;
-//             ConnContext *ctx = (ConnContext *)io_uring_cqe_get_data(cqe);
-//             int res = cqe->res;
-
-//             if (res < 0) {
-//                 // 错误处理 (忽略 -ECANCELED 等)
-//                 if (res != -ECANCELED && ctx->fd != server_fd) {
-//                     close(ctx->fd);
-//                 }
-//             } else {
-//                 switch (ctx->op) {
-//                     case OP_ACCEPT:
-//                         // res 是新的文件描述符
-//                         if (res >= 0 && res < MAX_CONNECTIONS) {
-//                             // 为新连接添加 READ
-//                             // 实际生产中应检查是否超过 MAX_CONNECTIONS
-//                             add_read(res); 
-//                         } else {
-//                             if (res >= 0) close(res); // 超过数组限制，关闭
-//                         }
-//                         // 继续监听新的连接
-//                         add_accept(server_fd);
-//                         break;
-
-//                     case OP_READ:
-//                         if (res == 0) {
-//                             // 客户端断开
-//                             close(ctx->fd);
-//                         } else {
-//                             // 读到数据，改为写回 (Echo)
-//                             add_write(ctx->fd, res);
-//                         }
-//                         break;
-
-//                     case OP_WRITE:
-//                         // 写完数据，继续读
-//                         add_read(ctx->fd);
-//                         break;
-//                 }
-//             }
-//         }
-        
-//         // 标记这批 CQE 已处理，推进内核队列指针
-//         io_uring_cq_advance(&ring, count);
-//     }
-
-//     close(server_fd);
-//     io_uring_queue_exit(&ring);
-//     return 0;
-// }
\ No newline at end of file
@@ -0,0 +1,228 @@
+// 基于 uring_loop 的回显服务器示例
+// 每个连接：recv (带空闲超时) -> send 直到写完 -> 再 recv；超时或对端关闭就关连接
+// 与 io_uring_server 使用同一端口，可以直接用 io_uring_client 压测
+//
+// 编译: make uring_echo
+// 运行: ./uring_echo [-E] [-i 空闲秒数] [-r] [-q]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "uring_loop.h"
+
+#define PORT 8080
+#define BUF_SIZE 1024
+#define BACKLOG 4096
+#define QUEUE_DEPTH 256
+
+typedef struct {
+    int fd;
+    size_t len;          // buf 里待回显的字节数
+    size_t sent;
+    char buf[BUF_SIZE];
+} Conn;
+
+typedef struct {
+    Loop *loop;
+    int listen_fd;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    long connections;
+    long requests;
+    long last_requests;
+} Server;
+
+Server server;
+int quiet = 0;
+int idle_ms = 30000;   // -i：连接空闲多久没有数据就关闭
+
+void on_recv(Loop *loop, int res, void *arg);
+
+void conn_close(Conn *c) {
+    if (!quiet) printf("Connection closed: FD %d\n", c->fd);
+    close(c->fd);
+    free(c);
+    server.connections--;
+}
+
+void start_recv(Loop *loop, Conn *c) {
+    if (!loop_recv(loop, c->fd, c->buf, sizeof(c->buf), idle_ms, on_recv, c)) {
+        conn_close(c);
+    }
+}
+
+void on_send(Loop *loop, int res, void *arg) {
+    Conn *c = arg;
+    if (res <= 0) {
+        conn_close(c);
+        return;
+    }
+    c->sent += res;
+    if (c->sent < c->len) {
+        // 短写：从断点续写
+        if (!loop_send(loop, c->fd, c->buf + c->sent, c->len - c->sent, 0, on_send, c)) conn_close(c);
+        return;
+    }
+    server.requests++;
+    start_recv(loop, c);
+}
+
+void on_recv(Loop *loop, int res, void *arg) {
+    Conn *c = arg;
+    if (res <= 0) {
+        if (res == -ETIMEDOUT && !quiet) printf("Idle timeout: FD %d\n", c->fd);
+        conn_close(c);
+        return;
+    }
+    c->len = res;
+    c->sent = 0;
+    if (!loop_send(loop, c->fd, c->buf, c->len, 0, on_send, c)) conn_close(c);
+}
+
+#define ACCEPT_BACKOFF_MS 100
+
+void start_accept(Loop *loop);
+
+// fd 用完时立即重试 accept 只会一直失败、空转占满 CPU，等一会儿 (期间有连接关闭会释放 fd) 再接
+void on_accept_backoff(Loop *loop, int res, void *arg) {
+    (void)res;
+    (void)arg;
+    start_accept(loop);
+}
+
+void on_accept(Loop *loop, int res, void *arg) {
+    (void)arg;
+    if (res >= 0) {
+        Conn *c = malloc(sizeof(Conn));
+        if (c) {
+            c->fd = res;
+            server.connections++;
+            if (!quiet) printf("New connection: FD %d\n", res);
+            start_recv(loop, c);
+        } else {
+            close(res);
+        }
+    } else if (res == -EMFILE || res == -ENFILE) {
+        fprintf(stderr, "Accept failed: %s, retrying in %d ms\n", strerror(-res), ACCEPT_BACKOFF_MS);
+        if (!loop_timeout(loop, ACCEPT_BACKOFF_MS, on_accept_backoff, NULL)) {
+            perror("loop_timeout");
+            loop_stop(loop);
+        }
+        return;
+    } else if (res != -ECANCELED) {
+        fprintf(stderr, "Accept failed: %s\n", strerror(-res));
+    }
+    start_accept(loop);
+}
+
+void start_accept(Loop *loop) {
+    server.addrlen = sizeof(server.addr);
+    if (!loop_accept(loop, server.listen_fd, (struct sockaddr *)&server.addr, &server.addrlen, on_accept, NULL)) {
+        perror("loop_accept");
+        loop_stop(loop);
+    }
+}
+
+// -r：每秒打印一次连接数和 QPS，定时器本身也是一个 loop 操作
+void on_report(Loop *loop, int res, void *arg) {
+    (void)res;
+    (void)arg;
+    printf("connections: %ld, qps: %ld\n", server.connections, server.requests - server.last_requests);
+    server.last_requests = server.requests;
+    loop_timeout(loop, 1000, on_report, NULL);
+}
+
+int create_listener(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Socket creation failed");
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(PORT);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Bind failed");
+        close(fd);
+        return -1;
+    }
+    if (listen(fd, BACKLOG) < 0) {
+        perror("Listen failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void handle_signal(int sig) {
+    (void)sig;
+    loop_stop(server.loop);  // 只设置标志；阻塞中的 io_uring_enter / epoll_wait 被信号打断后返回
+}
+
+int main(int argc, char *argv[]) {
+    int flags = 0;
+    int report = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "Ei:rqh")) != -1) {
+        switch (opt) {
+            case 'E':
+                flags |= LOOP_EPOLL;
+                break;
+            case 'i':
+                idle_ms = atoi(optarg) * 1000;
+                break;
+            case 'r':
+                report = 1;
+                break;
+            case 'q':
+                quiet = 1;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-E] [-i idle seconds] [-r] [-q]\n", argv[0]);
+                fprintf(stderr, "  -E  force the epoll backend\n");
+                fprintf(stderr, "  -i  close connections idle for this many seconds (default 30, 0 disables)\n");
+                fprintf(stderr, "  -r  report connections and QPS every second\n");
+                fprintf(stderr, "  -q  quiet, don't log every connection\n");
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    server.listen_fd = create_listener();
+    if (server.listen_fd < 0) return 1;
+    server.loop = loop_new(QUEUE_DEPTH, flags);
+    if (!server.loop) {
+        perror("loop_new");
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;  // 不设 SA_RESTART
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("Echo server listening on port %d (%s backend)...\n", PORT, loop_backend(server.loop));
+    start_accept(server.loop);
+    if (report) loop_timeout(server.loop, 1000, on_report, NULL);
+
+    int ret = loop_run(server.loop);
+    if (ret < 0) fprintf(stderr, "loop_run: %s\n", strerror(-ret));
+    fprintf(stderr, "requests: %ld\n", server.requests);
+
+    loop_free(server.loop);
+    close(server.listen_fd);
+    return 0;
+}
@@ -0,0 +1,356 @@
+#include "uring_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <liburing.h>
+
+#define NO_REQ UINT32_MAX
+
+// 一个在途操作；下标编码进 user_data
+typedef struct {
+    fe_cb cb;
+    void *arg;
+    void *buf;
+    uint32_t next;       // 空闲链表
+} FileReq;
+
+struct FileEngine {
+    struct io_uring ring;
+    int flags;
+    unsigned depth;
+    unsigned inflight;   // 占用请求槽位的操作数，包括已准备好 SQE 但还没提交的
+    FileReq *reqs;
+    uint32_t free_head;
+
+    size_t block_size;
+    char *pool;          // nbufs * block_size 的连续内存，FE_ALIGN 对齐
+    unsigned nbufs;
+    unsigned *free_bufs; // 空闲缓冲区下标栈
+    unsigned nfree_bufs;
+    int fixed;           // 缓冲池已注册为 fixed buffer，下标即缓冲区号
+};
+
+struct FileScan {
+    FileEngine *e;
+    int fd;
+    off_t next_off;      // 下一个要预读的块的偏移
+    off_t end;
+    unsigned window;
+    unsigned head;       // 最早发出、下一个交给调用方的槽位
+    int held;            // 上次交出去的槽位，下次调用时拿去预读后面的块；-1 表示没有
+    struct ScanSlot {
+        void *buf;
+        off_t off;       // -1 表示已经没有块可读
+        size_t len;
+        size_t done;     // 已经读到的字节数；中途短读时从这里接着读
+        ssize_t res;
+        int busy;
+    } *slots;
+};
+
+// ---------------------- 引擎 ----------------------
+
+FileEngine *fe_new(unsigned queue_depth, size_t block_size, unsigned nbufs, int flags) {
+    if (queue_depth == 0 || (nbufs && block_size == 0) ||
+        ((flags & FE_DIRECT) && block_size % FE_ALIGN)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    FileEngine *e = calloc(1, sizeof(FileEngine));
+    if (!e) return NULL;
+    e->flags = flags;
+    e->depth = queue_depth;
+    e->block_size = block_size;
+
+    // SQ 至少和队列深度一样大：待提交的 SQE 数不会超过在途数，get_sqe 不会失败
+    int ret = io_uring_queue_init(queue_depth, &e->ring, 0);
+    if (ret < 0) {
+        free(e);
+        errno = -ret;
+        return NULL;
+    }
+    e->reqs = calloc(queue_depth, sizeof(FileReq));
+    if (!e->reqs) goto fail;
+    e->free_head = NO_REQ;
+    for (uint32_t i = queue_depth; i > 0; i--) {
+        e->reqs[i - 1].next = e->free_head;
+        e->free_head = i - 1;
+    }
+
+    if (nbufs) {
+        if (posix_memalign((void **)&e->pool, FE_ALIGN, block_size * nbufs) != 0) goto fail;
+        e->free_bufs = malloc(sizeof(unsigned) * nbufs);
+        if (!e->free_bufs) goto fail;
+        e->nbufs = nbufs;
+        for (unsigned i = nbufs; i > 0; i--) e->free_bufs[e->nfree_bufs++] = i - 1;
+
+        // 注册后内核长期 pin 住这些页，每次 I/O 不用再 pin / unpin；失败 (如 RLIMIT_MEMLOCK) 就用普通读写
+        struct iovec *iov = malloc(sizeof(struct iovec) * nbufs);
+        if (iov) {
+            for (unsigned i = 0; i < nbufs; i++) {
+                iov[i].iov_base = e->pool + (size_t)i * block_size;
+                iov[i].iov_len = block_size;
+            }
+            ret = io_uring_register_buffers(&e->ring, iov, nbufs);
+            if (ret == 0) {
+                e->fixed = 1;
+            } else {
+                fprintf(stderr, "io_uring_register_buffers: %s, using unregistered buffers\n", strerror(-ret));
+            }
+            free(iov);
+        }
+    }
+    return e;
+
+fail:
+    fe_free(e);
+    errno = ENOMEM;
+    return NULL;
+}
+
+void fe_free(FileEngine *e) {
+    if (!e) return;
+    fe_drain(e);
+    io_uring_queue_exit(&e->ring);
+    free(e->reqs);
+    free(e->free_bufs);
+    free(e->pool);
+    free(e);
+}
+
+int fe_open(FileEngine *e, const char *path, int oflags, mode_t mode) {
+    if (!(e->flags & FE_DIRECT)) return open(path, oflags | O_CLOEXEC, mode);
+    int fd = open(path, oflags | O_CLOEXEC | O_DIRECT, mode);
+    if (fd < 0 && errno == EINVAL) {
+        fprintf(stderr, "%s: O_DIRECT not supported by the file system, using buffered I/O\n", path);
+        fd = open(path, oflags | O_CLOEXEC, mode);
+    }
+    return fd;
+}
+
+void *fe_buf_get(FileEngine *e) {
+    if (e->nfree_bufs == 0) return NULL;
+    return e->pool + (size_t)e->free_bufs[--e->nfree_bufs] * e->block_size;
+}
+
+void fe_buf_put(FileEngine *e, void *buf) {
+    e->free_bufs[e->nfree_bufs++] = ((char *)buf - e->pool) / e->block_size;
+}
+
+size_t fe_block_size(const FileEngine *e) {
+    return e->block_size;
+}
+
+unsigned fe_inflight(const FileEngine *e) {
+    return e->inflight;
+}
+
+// buf 整段落在某个池缓冲区内时返回它的 fixed buffer 下标，否则 -1
+static int fixed_index(const FileEngine *e, const void *buf, size_t len) {
+    if (!e->fixed) return -1;
+    const char *p = buf;
+    if (p < e->pool || p >= e->pool + (size_t)e->nbufs * e->block_size) return -1;
+    size_t off = p - e->pool;
+    if (off % e->block_size + len > e->block_size) return -1;
+    return (int)(off / e->block_size);
+}
+
+static int submit_op(FileEngine *e, int write, int fd, void *buf, size_t len, off_t offset, fe_cb cb, void *arg) {
+    if ((e->flags & FE_DIRECT) && (((uintptr_t)buf | len | (uint64_t)offset) & (FE_ALIGN - 1))) return -EINVAL;
+    if (len > UINT32_MAX) return -EINVAL;
+    // 队列深度满了：先收割完成事件 (会调用回调) 腾出槽位
+    while (e->inflight == e->depth) {
+        int ret = fe_poll(e, 1);
+        if (ret < 0) return ret;
+    }
+    uint32_t idx = e->free_head;
+    FileReq *req = &e->reqs[idx];
+    e->free_head = req->next;
+    req->cb = cb;
+    req->arg = arg;
+    req->buf = buf;
+    e->inflight++;
+
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&e->ring);
+    if (!sqe) {
+        io_uring_submit(&e->ring);
+        sqe = io_uring_get_sqe(&e->ring);
+    }
+    int bi = fixed_index(e, buf, len);
+    if (write) {
+        if (bi >= 0) {
+            io_uring_prep_write_fixed(sqe, fd, buf, len, offset, bi);
+        } else {
+            io_uring_prep_write(sqe, fd, buf, len, offset);
+        }
+    } else {
+        if (bi >= 0) {
+            io_uring_prep_read_fixed(sqe, fd, buf, len, offset, bi);
+        } else {
+            io_uring_prep_read(sqe, fd, buf, len, offset);
+        }
+    }
+    io_uring_sqe_set_data64(sqe, idx);
+    return 0;
+}
+
+int fe_read(FileEngine *e, int fd, void *buf, size_t len, off_t offset, fe_cb cb, void *arg) {
+    return submit_op(e, 0, fd, buf, len, offset, cb, arg);
+}
+
+int fe_write(FileEngine *e, int fd, const void *buf, size_t len, off_t offset, fe_cb cb, void *arg) {
+    return submit_op(e, 1, fd, (void *)buf, len, offset, cb, arg);
+}
+
+// 每个 CQE 先从 CQ 里摘掉、释放槽位再回调：回调里提交新操作甚至嵌套调用 fe_poll 都是安全的
+int fe_poll(FileEngine *e, unsigned min_complete) {
+    if (min_complete > e->inflight) min_complete = e->inflight;
+    int ret = io_uring_submit_and_wait(&e->ring, min_complete);
+    if (ret < 0 && ret != -EINTR) return ret;
+
+    unsigned done = 0;
+    for (;;) {
+        struct io_uring_cqe *cqe;
+        if (io_uring_peek_cqe(&e->ring, &cqe) != 0) {
+            if (done >= min_complete) break;
+            ret = io_uring_wait_cqe(&e->ring, &cqe);
+            if (ret == -EINTR) continue;
+            if (ret < 0) return ret;
+        }
+        uint32_t idx = (uint32_t)io_uring_cqe_get_data64(cqe);
+        int res = cqe->res;
+        io_uring_cqe_seen(&e->ring, cqe);
+
+        FileReq *req = &e->reqs[idx];
+        fe_cb cb = req->cb;
+        void *arg = req->arg;
+        void *buf = req->buf;
+        req->next = e->free_head;
+        e->free_head = idx;
+        e->inflight--;
+        done++;
+        if (cb) cb(e, res, buf, arg);
+    }
+    // 回调里提交的操作马上发出去，不等下一次 fe_poll
+    if (io_uring_sq_ready(&e->ring)) io_uring_submit(&e->ring);
+    return (int)done;
+}
+
+int fe_drain(FileEngine *e) {
+    while (e->inflight) {
+        int ret = fe_poll(e, e->inflight);
+        if (ret < 0) return ret;
+    }
+    return 0;
+}
+
+// ---------------------- 顺序预读 ----------------------
+
+static void scan_done(FileEngine *e, int res, void *buf, void *arg) {
+    (void)e;
+    (void)buf;
+    struct ScanSlot *slot = arg;
+    slot->res = res;
+    slot->busy = 0;
+}
+
+// 读槽位里还没读到的部分；O_DIRECT 下长度向上对齐，越过文件末尾的部分内核返回短读
+static int scan_read(FileScan *s, struct ScanSlot *slot) {
+    size_t len = slot->len;
+    if (s->e->flags & FE_DIRECT) len = (len + FE_ALIGN - 1) & ~(size_t)(FE_ALIGN - 1);
+    slot->busy = 1;
+    int ret = fe_read(s->e, s->fd, (char *)slot->buf + slot->done, len - slot->done,
+                      slot->off + (off_t)slot->done, scan_done, slot);
+    if (ret < 0) {
+        slot->busy = 0;
+        slot->res = ret;
+    }
+    return ret;
+}
+
+// 给槽位发下一个块的读
+static int scan_issue(FileScan *s, struct ScanSlot *slot) {
+    if (s->next_off >= s->end) {
+        slot->off = -1;
+        return 0;
+    }
+    size_t bs = s->e->block_size;
+    slot->off = s->next_off;
+    slot->len = s->end - s->next_off < (off_t)bs ? (size_t)(s->end - s->next_off) : bs;
+    slot->done = 0;
+    s->next_off += slot->len;
+    return scan_read(s, slot);
+}
+
+FileScan *fe_scan_open(FileEngine *e, int fd, off_t start, off_t end, unsigned window) {
+    if (window == 0 || window > e->nfree_bufs || start < 0 || start > end ||
+        ((e->flags & FE_DIRECT) && (start & (FE_ALIGN - 1)))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    FileScan *s = calloc(1, sizeof(FileScan));
+    if (!s) return NULL;
+    s->slots = calloc(window, sizeof(struct ScanSlot));
+    if (!s->slots) {
+        free(s);
+        return NULL;
+    }
+    s->e = e;
+    s->fd = fd;
+    s->next_off = start;
+    s->end = end;
+    s->window = window;
+    s->held = -1;
+    for (unsigned i = 0; i < window; i++) s->slots[i].buf = fe_buf_get(e);
+    // 一开始就把整个窗口的读发出去
+    for (unsigned i = 0; i < window; i++) scan_issue(s, &s->slots[i]);
+    return s;
+}
+
+ssize_t fe_scan_next(FileScan *s, void **buf) {
+    if (s->held >= 0) {
+        // 上一块调用方已经用完，这个缓冲区拿去读窗口之后的下一块
+        scan_issue(s, &s->slots[s->held]);
+        s->held = -1;
+    }
+    struct ScanSlot *slot = &s->slots[s->head];
+    if (slot->off < 0) return 0;
+    for (;;) {
+        while (slot->busy) {
+            int ret = fe_poll(s->e, 1);
+            if (ret < 0) return ret;
+        }
+        if (slot->res < 0) return slot->res;
+        slot->done += slot->res;
+        // 读满、读到文件末尾 (返回 0)，或 O_DIRECT 下没对齐的短读 (只会发生在文件末尾) 就交出去
+        if (slot->done >= slot->len || slot->res == 0 ||
+            ((s->e->flags & FE_DIRECT) && (slot->done & (FE_ALIGN - 1))))
+            break;
+        // 中途短读：后面的块已经在预读了，这里不补齐就会在扫描中间留下空洞
+        int ret = scan_read(s, slot);
+        if (ret < 0) return ret;
+    }
+    s->held = s->head;
+    s->head = (s->head + 1) % s->window;
+    *buf = slot->buf;
+    // O_DIRECT 多读出的对齐部分不交给调用方
+    return slot->done < slot->len ? (ssize_t)slot->done : (ssize_t)slot->len;
+}
+
+void fe_scan_close(FileScan *s) {
+    if (!s) return;
+    for (unsigned i = 0; i < s->window; i++) {
+        while (s->slots[i].busy) {
+            if (fe_poll(s->e, 1) < 0) break;
+        }
+        fe_buf_put(s->e, s->slots[i].buf);
+    }
+    free(s->slots);
+    free(s);
+}
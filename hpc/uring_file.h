@@ -0,0 +1,68 @@
+#ifndef URING_FILE_H
+#define URING_FILE_H
+
+// 基于 io_uring 的异步文件 I/O 引擎：批量读写、队列深度控制、O_DIRECT 对齐缓冲池、顺序预读
+//
+// 用法：
+//   1. fe_new 创建引擎，同时分配 nbufs 个 block_size 大小、FE_ALIGN 对齐的缓冲区并注册为 fixed buffer
+//   2. fe_read / fe_write 提交操作；在途操作达到 queue_depth 时在里面等到有操作完成为止
+//   3. fe_poll / fe_drain 收割完成事件并调用回调
+// 回调的 res 与 pread / pwrite 的返回值一致：字节数，失败为 -errno。回调里可以继续提交新操作
+//
+// 单线程使用：一个引擎只能在创建它的线程里操作
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// O_DIRECT 要求缓冲区地址、长度和文件偏移都按逻辑块对齐，这里统一按页对齐
+#define FE_ALIGN 4096
+
+typedef struct FileEngine FileEngine;
+typedef struct FileScan FileScan;
+
+typedef void (*fe_cb)(FileEngine *e, int res, void *buf, void *arg);
+
+enum {
+    FE_DIRECT = 1 << 0,  // fe_open 用 O_DIRECT 打开，绕过 page cache
+};
+
+// queue_depth：最多同时在途的操作数；nbufs 为 0 时不建缓冲池
+// 失败返回 NULL
+FileEngine *fe_new(unsigned queue_depth, size_t block_size, unsigned nbufs, int flags);
+void fe_free(FileEngine *e);
+
+// 按引擎的标志打开文件；文件系统不支持 O_DIRECT (如 tmpfs) 时退回普通打开并打印警告
+int fe_open(FileEngine *e, const char *path, int oflags, mode_t mode);
+
+// 缓冲池：池空时返回 NULL。池里的缓冲区已注册，读写时走 read_fixed / write_fixed
+void *fe_buf_get(FileEngine *e);
+void fe_buf_put(FileEngine *e, void *buf);
+size_t fe_block_size(const FileEngine *e);
+
+// 提交读 / 写，成功返回 0，参数不合法 (例如 O_DIRECT 下没对齐) 返回 -EINVAL，此时不会回调
+// buf 在回调之前必须保持有效
+int fe_read(FileEngine *e, int fd, void *buf, size_t len, off_t offset, fe_cb cb, void *arg);
+int fe_write(FileEngine *e, int fd, const void *buf, size_t len, off_t offset, fe_cb cb, void *arg);
+
+// 提交所有待提交的操作，至少等到 min_complete 个完成 (不超过在途数)，返回处理的完成数或 -errno
+int fe_poll(FileEngine *e, unsigned min_complete);
+// 等所有在途操作完成
+int fe_drain(FileEngine *e);
+unsigned fe_inflight(const FileEngine *e);
+
+// 顺序扫描 [start, end)：始终保持 window 个块的读在途 (预读)，fe_scan_next 按顺序交出已读好的块
+// 每个块占用一个池缓冲区，window 不能超过池里剩余的缓冲区数
+FileScan *fe_scan_open(FileEngine *e, int fd, off_t start, off_t end, unsigned window);
+// 返回块的字节数，0 表示读完，失败为 -errno；*buf 在下一次调用 fe_scan_next 之前有效
+ssize_t fe_scan_next(FileScan *s, void **buf);
+void fe_scan_close(FileScan *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
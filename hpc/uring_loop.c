@@ -0,0 +1,641 @@
+#include "uring_loop.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <liburing.h>
+
+#define OPS_PER_CHUNK 256
+#define EPOLL_BATCH 64
+#define NO_OP UINT32_MAX
+
+// io_uring user_data：操作本身是 loop_id，它的 linked timeout 加上这个标记，cancel 请求用 0
+#define TIMEOUT_TAG (1ULL << 63)
+#define GEN_MASK 0x7fffffffU
+
+typedef enum {
+    OP_ACCEPT,
+    OP_RECV,
+    OP_SEND,
+    OP_TIMEOUT,
+    OP_READ,
+    OP_WRITE
+} OpType;
+
+typedef struct {
+    uint32_t gen;        // 每次分配加一，和下标一起组成 loop_id，防止旧句柄取消到新操作
+    int active;
+    OpType type;
+    int fd;
+    void *buf;
+    size_t len;
+    off_t offset;
+    struct sockaddr *addr;
+    socklen_t *addrlen;
+    loop_cb cb;
+    void *arg;
+    int res;
+    int refs;            // io_uring：还没收到的 CQE 数 (操作本身 + linked timeout)
+    int timed_out;
+    struct __kernel_timespec ts;
+    uint64_t deadline;   // epoll：超时时刻 (ms)，0 表示没有
+    unsigned heap_idx;   // epoll：在定时器堆里的位置
+    uint32_t next;       // 空闲链表 / 就绪队列
+} LoopOp;
+
+// epoll 后端每个 fd 的等待状态：读方向 (accept / recv) 和写方向 (send) 各最多一个操作
+typedef struct {
+    uint32_t rd;         // 操作下标 + 1，0 表示没有
+    uint32_t wr;
+    uint32_t events;     // 当前注册到 epoll 的事件
+} FdWait;
+
+struct Loop {
+    int uring;           // 1: io_uring 后端，0: epoll 后端
+    int stopped;
+    unsigned pending;
+
+    LoopOp **chunks;
+    unsigned nchunks;
+    uint32_t free_head;
+
+    struct io_uring ring;
+
+    int epfd;
+    FdWait *fds;
+    unsigned nfds;
+    uint32_t ready_head;  // 已完成、等待回调的操作
+    uint32_t ready_tail;
+    uint32_t *heap;       // 按 deadline 排序的最小堆，存操作下标
+    unsigned heap_len;
+    unsigned heap_cap;
+};
+
+// ---------------------- 操作槽位 ----------------------
+
+static inline LoopOp *op_at(Loop *loop, uint32_t idx) {
+    return &loop->chunks[idx / OPS_PER_CHUNK][idx % OPS_PER_CHUNK];
+}
+
+static inline loop_id op_id(uint32_t idx, const LoopOp *op) {
+    return ((loop_id)op->gen << 32) | idx;
+}
+
+// 句柄对应的操作仍在途时返回它
+static LoopOp *op_lookup(Loop *loop, loop_id id, uint32_t *idx) {
+    uint32_t i = (uint32_t)id;
+    if (i >= loop->nchunks * OPS_PER_CHUNK) return NULL;
+    LoopOp *op = op_at(loop, i);
+    if (!op->active || op->gen != ((id >> 32) & GEN_MASK)) return NULL;
+    if (idx) *idx = i;
+    return op;
+}
+
+static LoopOp *op_alloc(Loop *loop, OpType type, loop_cb cb, void *arg, uint32_t *idx) {
+    if (loop->free_head == NO_OP) {
+        LoopOp **chunks = realloc(loop->chunks, sizeof(LoopOp *) * (loop->nchunks + 1));
+        if (!chunks) return NULL;
+        loop->chunks = chunks;
+        LoopOp *chunk = calloc(OPS_PER_CHUNK, sizeof(LoopOp));
+        if (!chunk) return NULL;
+        uint32_t base = loop->nchunks * OPS_PER_CHUNK;
+        loop->chunks[loop->nchunks++] = chunk;
+        // 倒序入栈，先分配低下标
+        for (uint32_t i = OPS_PER_CHUNK; i > 0; i--) {
+            chunk[i - 1].next = loop->free_head;
+            loop->free_head = base + i - 1;
+        }
+    }
+    *idx = loop->free_head;
+    LoopOp *op = op_at(loop, *idx);
+    loop->free_head = op->next;
+
+    uint32_t gen = (op->gen + 1) & GEN_MASK;
+    memset(op, 0, sizeof(*op));
+    op->gen = gen ? gen : 1;  // 保证句柄非 0
+    op->active = 1;
+    op->type = type;
+    op->cb = cb;
+    op->arg = arg;
+    op->fd = -1;
+    op->refs = 1;
+    loop->pending++;
+    return op;
+}
+
+// 释放槽位后再回调，回调里提交的新操作可以直接复用它
+static void op_finish(Loop *loop, uint32_t idx, int res) {
+    LoopOp *op = op_at(loop, idx);
+    loop_cb cb = op->cb;
+    void *arg = op->arg;
+    op->active = 0;
+    op->next = loop->free_head;
+    loop->free_head = idx;
+    loop->pending--;
+    if (cb) cb(loop, res, arg);
+}
+
+// ---------------------- io_uring 后端 ----------------------
+
+// 至少留出 n 个空位，linked 的两个 SQE 不能被一次中途的 submit 拆开
+// SQ 满了又提交不出去 (CQ 溢出时的 -EBUSY、-EAGAIN 等) 返回 NULL，errno 为失败原因
+static struct io_uring_sqe *uring_sqe(Loop *loop, unsigned n) {
+    if (io_uring_sq_space_left(&loop->ring) < n) {
+        int ret = io_uring_submit(&loop->ring);
+        if (ret < 0 && io_uring_sq_space_left(&loop->ring) < n) {
+            errno = -ret;
+            return NULL;
+        }
+        if (io_uring_sq_space_left(&loop->ring) < n) {
+            errno = EBUSY;
+            return NULL;
+        }
+    }
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&loop->ring);
+    if (!sqe) errno = EBUSY;
+    return sqe;
+}
+
+static void ms_to_ts(unsigned ms, struct __kernel_timespec *ts) {
+    ts->tv_sec = ms / 1000;
+    ts->tv_nsec = (long long)(ms % 1000) * 1000000;
+}
+
+// 成功返回 0，拿不到 SQE 返回 -errno (此时什么都没有提交)
+static int uring_submit_op(Loop *loop, uint32_t idx, LoopOp *op, int timeout_ms) {
+    struct io_uring_sqe *sqe = uring_sqe(loop, timeout_ms > 0 ? 2 : 1);
+    if (!sqe) return -errno;
+    switch (op->type) {
+        case OP_ACCEPT:
+            io_uring_prep_accept(sqe, op->fd, op->addr, op->addrlen, 0);
+            break;
+        case OP_RECV:
+            io_uring_prep_recv(sqe, op->fd, op->buf, op->len, 0);
+            break;
+        case OP_SEND:
+            io_uring_prep_send(sqe, op->fd, op->buf, op->len, MSG_NOSIGNAL);
+            break;
+        case OP_TIMEOUT:
+            io_uring_prep_timeout(sqe, &op->ts, 0, 0);
+            break;
+        case OP_READ:
+            io_uring_prep_read(sqe, op->fd, op->buf, op->len, op->offset);
+            break;
+        case OP_WRITE:
+            io_uring_prep_write(sqe, op->fd, op->buf, op->len, op->offset);
+            break;
+    }
+    io_uring_sqe_set_data64(sqe, op_id(idx, op));
+
+    if (timeout_ms > 0) {
+        // linked timeout：到期时内核取消前一个 SQE，两个 CQE 都到齐才回调
+        sqe->flags |= IOSQE_IO_LINK;
+        ms_to_ts(timeout_ms, &op->ts);
+        // uring_sqe 已经保证留出了两个空位
+        sqe = io_uring_get_sqe(&loop->ring);
+        io_uring_prep_link_timeout(sqe, &op->ts, 0);
+        io_uring_sqe_set_data64(sqe, op_id(idx, op) | TIMEOUT_TAG);
+        op->refs = 2;
+    }
+    return 0;
+}
+
+static void uring_handle_cqe(Loop *loop, struct io_uring_cqe *cqe) {
+    __u64 ud = io_uring_cqe_get_data64(cqe);
+    if (ud == 0) return;  // cancel 请求本身的结果
+    uint32_t idx;
+    LoopOp *op = op_lookup(loop, ud & ~TIMEOUT_TAG, &idx);
+    if (!op) return;
+
+    if (ud & TIMEOUT_TAG) {
+        if (cqe->res == -ETIME) op->timed_out = 1;
+    } else {
+        op->res = cqe->res;
+    }
+    if (--op->refs > 0) return;
+
+    int res = op->res;
+    if (op->type == OP_TIMEOUT && res == -ETIME) {
+        res = 0;
+    } else if (op->timed_out && res == -ECANCELED) {
+        res = -ETIMEDOUT;
+    }
+    op_finish(loop, idx, res);
+}
+
+static int uring_run(Loop *loop) {
+    while (!loop->stopped && loop->pending > 0) {
+        int ret = io_uring_submit_and_wait(&loop->ring, 1);
+        if (ret < 0 && ret != -EINTR && ret != -EBUSY) return ret;
+
+        struct io_uring_cqe *cqe;
+        unsigned head;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&loop->ring, head, cqe) {
+            uring_handle_cqe(loop, cqe);
+            count++;
+        }
+        io_uring_cq_advance(&loop->ring, count);
+    }
+    // 回调里最后提交的操作也要送进内核
+    io_uring_submit(&loop->ring);
+    return 0;
+}
+
+// ---------------------- epoll 后端 ----------------------
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void ready_push(Loop *loop, uint32_t idx, int res) {
+    LoopOp *op = op_at(loop, idx);
+    op->res = res;
+    op->next = NO_OP;
+    if (loop->ready_tail != NO_OP) {
+        op_at(loop, loop->ready_tail)->next = idx;
+    } else {
+        loop->ready_head = idx;
+    }
+    loop->ready_tail = idx;
+}
+
+// 定时器堆 (按 deadline 的最小堆)，每个操作记住自己的位置以便完成时删除
+static void heap_swap(Loop *loop, unsigned a, unsigned b) {
+    uint32_t t = loop->heap[a];
+    loop->heap[a] = loop->heap[b];
+    loop->heap[b] = t;
+    op_at(loop, loop->heap[a])->heap_idx = a;
+    op_at(loop, loop->heap[b])->heap_idx = b;
+}
+
+static uint64_t heap_key(Loop *loop, unsigned i) {
+    return op_at(loop, loop->heap[i])->deadline;
+}
+
+static void heap_fix(Loop *loop, unsigned i) {
+    while (i > 0 && heap_key(loop, (i - 1) / 2) > heap_key(loop, i)) {
+        heap_swap(loop, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        unsigned l = 2 * i + 1, r = l + 1, m = i;
+        if (l < loop->heap_len && heap_key(loop, l) < heap_key(loop, m)) m = l;
+        if (r < loop->heap_len && heap_key(loop, r) < heap_key(loop, m)) m = r;
+        if (m == i) break;
+        heap_swap(loop, i, m);
+        i = m;
+    }
+}
+
+static int heap_push(Loop *loop, uint32_t idx) {
+    if (loop->heap_len == loop->heap_cap) {
+        unsigned cap = loop->heap_cap ? loop->heap_cap * 2 : 64;
+        uint32_t *heap = realloc(loop->heap, sizeof(uint32_t) * cap);
+        if (!heap) return -ENOMEM;
+        loop->heap = heap;
+        loop->heap_cap = cap;
+    }
+    unsigned i = loop->heap_len++;
+    loop->heap[i] = idx;
+    op_at(loop, idx)->heap_idx = i;
+    heap_fix(loop, i);
+    return 0;
+}
+
+static void heap_remove(Loop *loop, LoopOp *op) {
+    if (!op->deadline) return;
+    unsigned i = op->heap_idx;
+    op->deadline = 0;
+    if (i != --loop->heap_len) {
+        heap_swap(loop, i, loop->heap_len);
+        heap_fix(loop, i);
+    }
+}
+
+static FdWait *fd_wait(Loop *loop, int fd) {
+    if ((unsigned)fd >= loop->nfds) {
+        unsigned n = loop->nfds ? loop->nfds : 64;
+        while (n <= (unsigned)fd) n *= 2;
+        FdWait *fds = realloc(loop->fds, sizeof(FdWait) * n);
+        if (!fds) return NULL;
+        memset(fds + loop->nfds, 0, sizeof(FdWait) * (n - loop->nfds));
+        loop->fds = fds;
+        loop->nfds = n;
+    }
+    return &loop->fds[fd];
+}
+
+// 按当前等待的操作更新 epoll 注册 (水平触发)
+static int fd_update(Loop *loop, int fd, FdWait *fw) {
+    uint32_t events = (fw->rd ? EPOLLIN : 0) | (fw->wr ? EPOLLOUT : 0);
+    if (events == fw->events) return 0;
+    struct epoll_event ev = { .events = events, .data.fd = fd };
+    int ret;
+    if (events == 0) {
+        ret = epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd, NULL);
+    } else if (fw->events == 0) {
+        ret = epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev);
+        if (ret < 0 && errno == EEXIST) ret = epoll_ctl(loop->epfd, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+        ret = epoll_ctl(loop->epfd, EPOLL_CTL_MOD, fd, &ev);
+        // fd 被关闭后内核已经自动移除，记录的状态过期了
+        if (ret < 0 && errno == ENOENT) ret = epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    if (ret < 0 && events != 0) return -errno;
+    fw->events = events;
+    return 0;
+}
+
+// 非阻塞地执行一次 syscall，返回 -EAGAIN 表示要等 fd 就绪
+static int epoll_try(LoopOp *op) {
+    ssize_t r = 0;
+    switch (op->type) {
+        case OP_ACCEPT:
+            r = accept(op->fd, op->addr, op->addrlen);
+            break;
+        case OP_RECV:
+            r = recv(op->fd, op->buf, op->len, MSG_DONTWAIT);
+            break;
+        case OP_SEND:
+            r = send(op->fd, op->buf, op->len, MSG_DONTWAIT | MSG_NOSIGNAL);
+            break;
+        case OP_READ:
+            r = pread(op->fd, op->buf, op->len, op->offset);
+            break;
+        case OP_WRITE:
+            r = pwrite(op->fd, op->buf, op->len, op->offset);
+            break;
+        case OP_TIMEOUT:
+            return -EAGAIN;
+    }
+    if (r < 0) return errno == EWOULDBLOCK ? -EAGAIN : -errno;
+    return (int)r;
+}
+
+// 从 fd 等待表和定时器堆里摘掉
+static void epoll_unpark(Loop *loop, uint32_t idx, LoopOp *op) {
+    heap_remove(loop, op);
+    if (op->fd < 0 || op->type == OP_READ || op->type == OP_WRITE) return;
+    FdWait *fw = &loop->fds[op->fd];
+    if (fw->rd == idx + 1) fw->rd = 0;
+    if (fw->wr == idx + 1) fw->wr = 0;
+    fd_update(loop, op->fd, fw);
+}
+
+static int epoll_submit_op(Loop *loop, uint32_t idx, LoopOp *op, int timeout_ms) {
+    if (op->type != OP_TIMEOUT) {
+        int res = epoll_try(op);
+        if (res != -EAGAIN || op->type == OP_READ || op->type == OP_WRITE) {
+            // 立即完成的操作也放到就绪队列，回调统一在 loop_run 里调用
+            ready_push(loop, idx, res);
+            return 0;
+        }
+        FdWait *fw = fd_wait(loop, op->fd);
+        if (!fw) return -ENOMEM;
+        uint32_t *slot = op->type == OP_SEND ? &fw->wr : &fw->rd;
+        if (*slot) return -EBUSY;  // 同一方向已有在途操作
+        *slot = idx + 1;
+        int ret = fd_update(loop, op->fd, fw);
+        if (ret < 0) {
+            *slot = 0;
+            return ret;
+        }
+    }
+    if (timeout_ms > 0) {
+        op->deadline = now_ms() + timeout_ms;
+        if (heap_push(loop, idx) < 0) {
+            op->deadline = 0;
+            epoll_unpark(loop, idx, op);
+            return -ENOMEM;
+        }
+    }
+    return 0;
+}
+
+static void epoll_handle_event(Loop *loop, struct epoll_event *ev) {
+    int fd = ev->data.fd;
+    for (int dir = 0; dir < 2; dir++) {
+        uint32_t mask = dir == 0 ? EPOLLIN : EPOLLOUT;
+        if (!(ev->events & (mask | EPOLLERR | EPOLLHUP))) continue;
+        // 每次重新读等待表：前一个回调可能取消了另一方向的操作、提交了新操作，甚至扩容了 fd 表
+        uint32_t slot = dir == 0 ? loop->fds[fd].rd : loop->fds[fd].wr;
+        if (!slot) continue;
+        uint32_t idx = slot - 1;
+        LoopOp *op = op_at(loop, idx);
+        int res = epoll_try(op);
+        if (res == -EAGAIN) continue;  // 假唤醒，继续等
+        epoll_unpark(loop, idx, op);
+        op_finish(loop, idx, res);
+    }
+}
+
+static void epoll_expire(Loop *loop) {
+    uint64_t now = now_ms();
+    while (loop->heap_len > 0 && heap_key(loop, 0) <= now) {
+        uint32_t idx = loop->heap[0];
+        LoopOp *op = op_at(loop, idx);
+        epoll_unpark(loop, idx, op);
+        op_finish(loop, idx, op->type == OP_TIMEOUT ? 0 : -ETIMEDOUT);
+    }
+}
+
+static int epoll_run(Loop *loop) {
+    struct epoll_event events[EPOLL_BATCH];
+    while (!loop->stopped && loop->pending > 0) {
+        while (loop->ready_head != NO_OP) {
+            uint32_t idx = loop->ready_head;
+            LoopOp *op = op_at(loop, idx);
+            loop->ready_head = op->next;
+            if (loop->ready_head == NO_OP) loop->ready_tail = NO_OP;
+            op_finish(loop, idx, op->res);
+        }
+        if (loop->stopped || loop->pending == 0) break;
+
+        int timeout = -1;
+        if (loop->heap_len > 0) {
+            uint64_t now = now_ms(), deadline = heap_key(loop, 0);
+            timeout = deadline > now ? (int)(deadline - now) : 0;
+        }
+        int n = epoll_wait(loop->epfd, events, EPOLL_BATCH, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        for (int i = 0; i < n; i++) {
+            epoll_handle_event(loop, &events[i]);
+        }
+        epoll_expire(loop);
+    }
+    return 0;
+}
+
+// ---------------------- 公共接口 ----------------------
+
+Loop *loop_new(unsigned entries, int flags) {
+    Loop *loop = calloc(1, sizeof(Loop));
+    if (!loop) return NULL;
+    loop->free_head = NO_OP;
+    loop->ready_head = loop->ready_tail = NO_OP;
+    loop->epfd = -1;
+
+    if (!(flags & LOOP_EPOLL)) {
+        int ret = io_uring_queue_init(entries, &loop->ring, 0);
+        if (ret == 0) {
+            loop->uring = 1;
+            return loop;
+        }
+        // 老内核 (ENOSYS) 或被 seccomp / sysctl 禁用 (EPERM)
+        fprintf(stderr, "io_uring unavailable (%s), falling back to epoll\n", strerror(-ret));
+    }
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epfd < 0) {
+        free(loop);
+        return NULL;
+    }
+    return loop;
+}
+
+void loop_free(Loop *loop) {
+    if (!loop) return;
+    if (loop->uring) {
+        io_uring_queue_exit(&loop->ring);
+    } else {
+        close(loop->epfd);
+    }
+    for (unsigned i = 0; i < loop->nchunks; i++) {
+        free(loop->chunks[i]);
+    }
+    free(loop->chunks);
+    free(loop->fds);
+    free(loop->heap);
+    free(loop);
+}
+
+const char *loop_backend(const Loop *loop) {
+    return loop->uring ? "io_uring" : "epoll";
+}
+
+int loop_run(Loop *loop) {
+    loop->stopped = 0;
+    return loop->uring ? uring_run(loop) : epoll_run(loop);
+}
+
+void loop_stop(Loop *loop) {
+    loop->stopped = 1;
+}
+
+unsigned loop_pending(const Loop *loop) {
+    return loop->pending;
+}
+
+static loop_id submit(Loop *loop, uint32_t idx, LoopOp *op, int timeout_ms) {
+    int ret = loop->uring ? uring_submit_op(loop, idx, op, timeout_ms) : epoll_submit_op(loop, idx, op, timeout_ms);
+    if (ret < 0) {
+        // 提交失败不回调，直接归还槽位
+        op->cb = NULL;
+        op_finish(loop, idx, ret);
+        errno = -ret;
+        return 0;
+    }
+    return op_id(idx, op);
+}
+
+static LoopOp *prep(Loop *loop, OpType type, int fd, void *buf, size_t len, loop_cb cb, void *arg, uint32_t *idx) {
+    LoopOp *op = op_alloc(loop, type, cb, arg, idx);
+    if (!op) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    op->fd = fd;
+    op->buf = buf;
+    op->len = len;
+    return op;
+}
+
+loop_id loop_accept(Loop *loop, int fd, struct sockaddr *addr, socklen_t *addrlen, loop_cb cb, void *arg) {
+    uint32_t idx;
+    LoopOp *op = prep(loop, OP_ACCEPT, fd, NULL, 0, cb, arg, &idx);
+    if (!op) return 0;
+    op->addr = addr;
+    op->addrlen = addrlen;
+    if (!loop->uring) {
+        // epoll 下监听 socket 必须非阻塞，否则被别的进程抢走连接时 accept 会卡住整个循环
+        int fl = fcntl(fd, F_GETFL);
+        if (fl >= 0 && !(fl & O_NONBLOCK)) fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+    }
+    return submit(loop, idx, op, 0);
+}
+
+loop_id loop_recv(Loop *loop, int fd, void *buf, size_t len, int timeout_ms, loop_cb cb, void *arg) {
+    uint32_t idx;
+    LoopOp *op = prep(loop, OP_RECV, fd, buf, len, cb, arg, &idx);
+    return op ? submit(loop, idx, op, timeout_ms) : 0;
+}
+
+loop_id loop_send(Loop *loop, int fd, const void *buf, size_t len, int timeout_ms, loop_cb cb, void *arg) {
+    uint32_t idx;
+    LoopOp *op = prep(loop, OP_SEND, fd, (void *)buf, len, cb, arg, &idx);
+    return op ? submit(loop, idx, op, timeout_ms) : 0;
+}
+
+loop_id loop_timeout(Loop *loop, unsigned ms, loop_cb cb, void *arg) {
+    uint32_t idx;
+    LoopOp *op = prep(loop, OP_TIMEOUT, -1, NULL, 0, cb, arg, &idx);
+    if (!op) return 0;
+    if (loop->uring) {
+        ms_to_ts(ms, &op->ts);
+        return submit(loop, idx, op, 0);
+    }
+    // 0 ms 也要经过一次 epoll_wait 才回调
+    return submit(loop, idx, op, ms ? (int)ms : 1);
+}
+
+loop_id loop_read(Loop *loop, int fd, void *buf, size_t len, off_t offset, loop_cb cb, void *arg) {
+    uint32_t idx;
+    LoopOp *op = prep(loop, OP_READ, fd, buf, len, cb, arg, &idx);
+    if (!op) return 0;
+    op->offset = offset;
+    return submit(loop, idx, op, 0);
+}
+
+loop_id loop_write(Loop *loop, int fd, const void *buf, size_t len, off_t offset, loop_cb cb, void *arg) {
+    uint32_t idx;
+    LoopOp *op = prep(loop, OP_WRITE, fd, (void *)buf, len, cb, arg, &idx);
+    if (!op) return 0;
+    op->offset = offset;
+    return submit(loop, idx, op, 0);
+}
+
+int loop_cancel(Loop *loop, loop_id id) {
+    uint32_t idx;
+    LoopOp *op = op_lookup(loop, id, &idx);
+    if (!op) return -ENOENT;
+    if (loop->uring) {
+        // 内核里可能已经完成、CQE 还没处理，这时回调拿到的是真实结果
+        struct io_uring_sqe *sqe = uring_sqe(loop, 1);
+        if (!sqe) return -errno;
+        io_uring_prep_cancel64(sqe, id, 0);
+        io_uring_sqe_set_data64(sqe, 0);
+        return 0;
+    }
+    // 已经在就绪队列里的操作不能再取消
+    if (op->deadline == 0) {
+        int parked = 0;
+        if (op->fd >= 0 && (unsigned)op->fd < loop->nfds) {
+            FdWait *fw = &loop->fds[op->fd];
+            parked = fw->rd == idx + 1 || fw->wr == idx + 1;
+        }
+        if (!parked) return -ENOENT;
+    }
+    epoll_unpark(loop, idx, op);
+    ready_push(loop, idx, -ECANCELED);
+    return 0;
+}
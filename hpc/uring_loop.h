@@ -0,0 +1,69 @@
+#ifndef URING_LOOP_H
+#define URING_LOOP_H
+
+// 小型异步 I/O 事件循环：提交操作时带一个回调，完成时在 loop_run 里被调用
+// 后端优先用 io_uring；内核不支持 (或 LOOP_EPOLL 强制) 时退回 epoll + 非阻塞 syscall，接口和语义不变
+//
+// 回调的 res 与对应 syscall 的返回值一致：字节数 / 新连接 fd / 0，失败为 -errno
+//   loop_cancel 取消的操作       -ECANCELED
+//   timeout_ms 到期的 recv/send  -ETIMEDOUT
+//   loop_timeout 正常到期        0
+// 每个成功提交的操作恰好回调一次。回调里可以继续提交新操作
+//
+// 单线程使用：一个 Loop 只能在创建它的线程里操作
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Loop Loop;
+
+// 操作句柄，用于 loop_cancel；操作完成后句柄失效，不会误取消后来复用同一槽位的操作
+typedef uint64_t loop_id;
+
+typedef void (*loop_cb)(Loop *loop, int res, void *arg);
+
+enum {
+    LOOP_EPOLL = 1 << 0,  // 强制使用 epoll 后端
+};
+
+// entries：io_uring 的 SQ 深度，epoll 后端忽略；失败返回 NULL
+Loop *loop_new(unsigned entries, int flags);
+void loop_free(Loop *loop);
+
+// "io_uring" 或 "epoll"
+const char *loop_backend(const Loop *loop);
+
+// 处理完成事件直到 loop_stop 或没有在途操作，返回 0 或 -errno
+int loop_run(Loop *loop);
+void loop_stop(Loop *loop);
+
+// 在途操作数
+unsigned loop_pending(const Loop *loop);
+
+// 提交操作，成功返回句柄，失败返回 0 (此时不会回调)
+// fd 上的缓冲区在回调之前必须保持有效
+// recv / send 的 timeout_ms > 0 时附带超时 (io_uring 下是 linked timeout)
+loop_id loop_accept(Loop *loop, int fd, struct sockaddr *addr, socklen_t *addrlen, loop_cb cb, void *arg);
+loop_id loop_recv(Loop *loop, int fd, void *buf, size_t len, int timeout_ms, loop_cb cb, void *arg);
+loop_id loop_send(Loop *loop, int fd, const void *buf, size_t len, int timeout_ms, loop_cb cb, void *arg);
+loop_id loop_timeout(Loop *loop, unsigned ms, loop_cb cb, void *arg);
+
+// 普通文件按偏移读写；epoll 后端直接同步 pread / pwrite，回调仍在 loop_run 里调用
+loop_id loop_read(Loop *loop, int fd, void *buf, size_t len, off_t offset, loop_cb cb, void *arg);
+loop_id loop_write(Loop *loop, int fd, const void *buf, size_t len, off_t offset, loop_cb cb, void *arg);
+
+// 取消在途操作，它的回调会收到 -ECANCELED；已经完成或句柄无效返回 -ENOENT
+// io_uring 下 SQ 满且提交失败 (如 CQ 溢出时的 -EBUSY) 返回 -errno，操作不受影响
+int loop_cancel(Loop *loop, loop_id id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
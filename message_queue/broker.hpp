@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "mq_tmpl.hpp"
+
+// 进程内发布订阅：主题用 '.' 分段
+// 订阅模式里 '*' 匹配恰好一段 '#' 匹配剩余任意多段（包括零段）
+// 例："market.*.AAPL" 匹配 "market.quotes.AAPL"；"market.#" 匹配 "market" 下所有主题
+
+// 不可变消息 发布时只构造一次 所有订阅者共享同一份（引用计数 零拷贝扇出）
+struct BrokerMessage {
+    std::string topic;
+    std::string payload;
+    uint64_t seq;   // 全局发布序号
+};
+using MessagePtr = std::shared_ptr<const BrokerMessage>;
+
+// 订阅者统计 lag 为已投递但还没被消费的条数
+struct SubscriberStats {
+    uint64_t delivered;
+    uint64_t consumed;
+    uint64_t dropped;
+    size_t lag;
+    size_t high_water;
+};
+
+class Subscription {
+public:
+    Subscription(std::string pattern, size_t capacity, OverflowPolicy policy)
+        : pattern_(std::move(pattern)), queue_(capacity, policy) {}
+
+    const std::string& pattern() const { return pattern_; }
+
+    QueueStatus pop(MessagePtr& out) { return queue_.pop(out); }
+
+    template <typename Rep, typename Period>
+    QueueStatus pop_batch(std::deque<MessagePtr>& out, size_t max,
+                          const std::chrono::duration<Rep, Period>& timeout) {
+        return queue_.pop_batch(out, max, timeout);
+    }
+
+    bool try_pop(MessagePtr& out) { return queue_.try_pop(out); }
+
+    size_t lag() const { return queue_.size(); }
+
+    SubscriberStats stats() const {
+        QueueStats st = queue_.stats();
+        return {st.pushed, st.popped, st.dropped, st.size, st.high_water};
+    }
+
+private:
+    friend class Broker;
+
+    std::string pattern_;
+    MessageQueue<MessagePtr> queue_;    // 每个订阅者一个有界队列 慢订阅者不拖累别人
+};
+
+class Broker {
+public:
+    // 默认满了丢最旧的：发布者永远不会被某个慢订阅者卡住
+    // max_routes 限制路由缓存的条目数 主题基数很高 (order.<id> 之类) 时内存不会无限增长
+    // 没有订阅者的主题另记在一个同样上限的未命中集合里 不会挤掉热主题的路由
+    explicit Broker(size_t ring_capacity = 1024,
+                    OverflowPolicy policy = OverflowPolicy::DropOldest,
+                    size_t max_routes = 4096)
+        : ring_capacity_(ring_capacity), policy_(policy), max_routes_(max_routes) {}
+
+    ~Broker() { stop(); }
+
+    Broker(const Broker&) = delete;
+    Broker& operator=(const Broker&) = delete;
+
+    // capacity 为 0 时使用 broker 的默认容量
+    std::shared_ptr<Subscription> subscribe(const std::string& pattern, size_t capacity = 0) {
+        auto sub = std::make_shared<Subscription>(
+            pattern, capacity ? capacity : ring_capacity_, policy_);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        subs_.push_back(sub);
+        invalidate_routes();    // 订阅关系变化 路由缓存失效
+        return sub;
+    }
+
+    void unsubscribe(const std::shared_ptr<Subscription>& sub) {
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            for (size_t i = 0; i < subs_.size(); i++) {
+                if (subs_[i] == sub) {
+                    subs_.erase(subs_.begin() + i);
+                    break;
+                }
+            }
+            invalidate_routes();
+        }
+        sub->queue_.stop();
+    }
+
+    // 返回投递到的订阅者个数
+    size_t publish(const std::string& topic, std::string payload) {
+        auto msg = std::make_shared<BrokerMessage>();
+        msg->topic = topic;
+        msg->payload = std::move(payload);
+        msg->seq = next_seq_.fetch_add(1, std::memory_order_relaxed);
+        return publish(MessagePtr(std::move(msg)));
+    }
+
+    size_t publish(const MessagePtr& msg) {
+        // 只在锁内拿到路由表的引用 扇出在锁外进行
+        // 这样 Block 策略的订阅者阻塞时也不会卡住 subscribe/unsubscribe
+        std::shared_ptr<const Route> route = lookup(msg->topic);
+        for (const auto& sub : *route) {
+            sub->queue_.push(msg);  // 只拷贝指针 引用计数 +1
+        }
+        published_.fetch_add(1, std::memory_order_relaxed);
+        return route->size();
+    }
+
+    // 停止所有订阅者队列 消费者取空后 pop 返回 Stopped
+    void stop() {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& sub : subs_) sub->queue_.stop();
+    }
+
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+
+    // 当前缓存的路由条数 / 未命中主题条数 都不超过 max_routes
+    size_t route_cache_size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return routes_.size();
+    }
+
+    size_t miss_cache_size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return misses_.size();
+    }
+
+    // 缓存未命中、遍历全部订阅模式算路由的次数
+    uint64_t route_scans() const { return route_scans_.load(std::memory_order_relaxed); }
+
+    // 主题是否匹配订阅模式
+    static bool match(const std::string& pattern, const std::string& topic) {
+        return match_from(pattern, 0, topic, 0);
+    }
+
+private:
+    using Route = std::vector<std::shared_ptr<Subscription>>;
+
+    std::shared_ptr<const Route> lookup(const std::string& topic) {
+        auto route = std::make_shared<Route>();
+        uint64_t generation;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = routes_.find(topic);
+            if (it != routes_.end()) return it->second;
+            if (misses_.count(topic)) return empty_route_;
+            // 未命中：在读锁下遍历所有订阅模式算出路由 多个发布者可以同时算
+            for (const auto& sub : subs_) {
+                if (match(sub->pattern_, topic)) route->push_back(sub);
+            }
+            generation = generation_;
+        }
+        route_scans_.fetch_add(1, std::memory_order_relaxed);
+        // 写锁只用来写回缓存；其间订阅关系变了 算出的路由已经过时 不缓存
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (generation != generation_ || max_routes_ == 0) return route->empty() ? empty_route_ : route;
+        // 两张表各自满了整体清空 重新预热的代价只是每个主题再匹配一遍
+        if (route->empty()) {
+            if (misses_.size() >= max_routes_) misses_.clear();
+            misses_.insert(topic);
+            return empty_route_;
+        }
+        if (routes_.size() >= max_routes_) routes_.clear();
+        routes_.emplace(topic, route);
+        return route;
+    }
+
+    // 调用方持有写锁
+    void invalidate_routes() {
+        routes_.clear();
+        misses_.clear();
+        generation_++;
+    }
+
+    // 取 s 中从 pos 开始的一段 返回段尾位置
+    static size_t segment_end(const std::string& s, size_t pos) {
+        size_t end = s.find('.', pos);
+        return end == std::string::npos ? s.size() : end;
+    }
+
+    static bool match_from(const std::string& p, size_t pi, const std::string& t, size_t ti) {
+        while (pi < p.size()) {
+            size_t pe = segment_end(p, pi);
+            size_t plen = pe - pi;
+            if (plen == 1 && p[pi] == '#') {
+                if (pe == p.size()) return true;    // 末尾的 '#' 吞掉剩余所有段
+                // 中间的 '#'：尝试让它匹配 0..n 段
+                for (size_t tj = ti; ; ) {
+                    if (match_from(p, pe + 1, t, tj)) return true;
+                    if (tj >= t.size()) return false;
+                    tj = segment_end(t, tj) + 1;
+                }
+            }
+            if (ti > t.size()) return false;    // 主题段数不够
+            size_t te = segment_end(t, ti);
+            bool star = plen == 1 && p[pi] == '*';
+            if (!star && (plen != te - ti || p.compare(pi, plen, t, ti, plen) != 0)) {
+                return false;
+            }
+            pi = pe + 1;
+            ti = te + 1;
+        }
+        return ti > t.size();   // 模式和主题必须同时用完
+    }
+
+    size_t ring_capacity_;
+    OverflowPolicy policy_;
+    size_t max_routes_;
+    const std::shared_ptr<const Route> empty_route_ = std::make_shared<Route>();
+    mutable std::shared_mutex mutex_;
+    std::vector<std::shared_ptr<Subscription>> subs_;
+    std::unordered_map<std::string, std::shared_ptr<const Route>> routes_;
+    std::unordered_set<std::string> misses_;    // 没有订阅者的主题
+    uint64_t generation_ = 0;                   // 订阅关系每变一次加一 受 mutex_ 保护
+    std::atomic<uint64_t> route_scans_{0};
+    std::atomic<uint64_t> next_seq_{0};
+    std::atomic<uint64_t> published_{0};
+};
@@ -0,0 +1,130 @@
+// Broker 扇出基准：1 / 8 / 64 个订阅者
+// 对比 零拷贝（共享 MessagePtr）与 每个订阅者各拷贝一份 payload
+// 编译: make broker_bench
+// 运行: ./broker_bench [消息条数] [payload 字节数]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "broker.hpp"
+
+struct Result {
+    double publish_rate;    // 发布端 msg/s
+    double delivery_rate;   // 订阅端合计 msg/s
+    uint64_t dropped;
+    size_t max_high_water;
+};
+
+// 订阅模式一半精确一半通配 让路由表里两种都有
+static std::string pattern_for(int i) {
+    switch (i % 3) {
+        case 0:  return "market.quotes.AAPL";
+        case 1:  return "market.*.AAPL";
+        default: return "market.#";
+    }
+}
+
+static Result bench_broker(int subscribers, int messages, size_t payload_size) {
+    Broker broker(4096);
+    std::vector<std::shared_ptr<Subscription>> subs;
+    for (int i = 0; i < subscribers; i++) subs.push_back(broker.subscribe(pattern_for(i)));
+
+    std::atomic<uint64_t> received{0};
+    std::vector<std::thread> consumers;
+    for (auto& sub : subs) {
+        consumers.emplace_back([&received, sub] {
+            std::deque<MessagePtr> batch;
+            uint64_t local = 0;
+            while (sub->pop_batch(batch, 256, std::chrono::milliseconds(10)) != QueueStatus::Stopped) {
+                local += batch.size();
+                batch.clear();
+            }
+            received += local;
+        });
+    }
+
+    std::string payload(payload_size, 'x');
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < messages; i++) broker.publish("market.quotes.AAPL", payload);
+    auto published = std::chrono::steady_clock::now();
+    broker.stop();
+    for (auto& t : consumers) t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    Result r{};
+    r.publish_rate = messages / std::chrono::duration<double>(published - start).count();
+    r.delivery_rate = received.load() / std::chrono::duration<double>(end - start).count();
+    for (auto& sub : subs) {
+        SubscriberStats st = sub->stats();
+        r.dropped += st.dropped;
+        if (st.high_water > r.max_high_water) r.max_high_water = st.high_water;
+    }
+    return r;
+}
+
+// 基线：每个订阅者一个 MessageQueue<std::string> 发布时逐个拷贝 payload
+static Result bench_copy(int subscribers, int messages, size_t payload_size) {
+    std::vector<std::unique_ptr<MessageQueue<std::string>>> queues;
+    for (int i = 0; i < subscribers; i++) {
+        queues.emplace_back(new MessageQueue<std::string>(4096, OverflowPolicy::DropOldest));
+    }
+
+    std::atomic<uint64_t> received{0};
+    std::vector<std::thread> consumers;
+    for (auto& q : queues) {
+        MessageQueue<std::string>* qp = q.get();
+        consumers.emplace_back([&received, qp] {
+            std::deque<std::string> batch;
+            uint64_t local = 0;
+            while (qp->pop_batch(batch, 256, std::chrono::milliseconds(10)) != QueueStatus::Stopped) {
+                local += batch.size();
+                batch.clear();
+            }
+            received += local;
+        });
+    }
+
+    std::string payload(payload_size, 'x');
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < messages; i++) {
+        for (auto& q : queues) q->push(payload);
+    }
+    auto published = std::chrono::steady_clock::now();
+    for (auto& q : queues) q->stop();
+    for (auto& t : consumers) t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    Result r{};
+    r.publish_rate = messages / std::chrono::duration<double>(published - start).count();
+    r.delivery_rate = received.load() / std::chrono::duration<double>(end - start).count();
+    for (auto& q : queues) {
+        QueueStats st = q->stats();
+        r.dropped += st.dropped;
+        if (st.high_water > r.max_high_water) r.max_high_water = st.high_water;
+    }
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    int messages = argc > 1 ? std::atoi(argv[1]) : 100000;
+    size_t payload_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024;
+    const int fanouts[] = {1, 8, 64};
+
+    std::printf("messages=%d payload=%zu bytes\n", messages, payload_size);
+    std::printf("%-6s %-10s %14s %16s %10s %10s\n",
+                "subs", "mode", "publish msg/s", "delivered msg/s", "dropped", "max lag");
+    for (int n : fanouts) {
+        Result z = bench_broker(n, messages, payload_size);
+        Result c = bench_copy(n, messages, payload_size);
+        std::printf("%-6d %-10s %14.0f %16.0f %10llu %10zu\n", n, "zero-copy",
+                    z.publish_rate, z.delivery_rate, (unsigned long long)z.dropped, z.max_high_water);
+        std::printf("%-6d %-10s %14.0f %16.0f %10llu %10zu\n", n, "copy",
+                    c.publish_rate, c.delivery_rate, (unsigned long long)c.dropped, c.max_high_water);
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Broker 的功能自检：主题匹配规则 + 路由缓存 / 未命中缓存在高基数主题下保持有界
+// 编译: make broker_demo
+// 运行: ./broker_demo  全部断言通过后打印 ok
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+#include "broker.hpp"
+
+static void check_match() {
+    assert(Broker::match("market.quotes.AAPL", "market.quotes.AAPL"));
+    assert(Broker::match("market.*.AAPL", "market.quotes.AAPL"));
+    assert(!Broker::match("market.*.AAPL", "market.quotes.MSFT"));
+    assert(!Broker::match("market.*", "market.quotes.AAPL"));
+    assert(Broker::match("market.#", "market"));
+    assert(Broker::match("market.#", "market.quotes.AAPL"));
+    assert(Broker::match("market.#.AAPL", "market.AAPL"));
+    assert(Broker::match("market.#.AAPL", "market.a.b.AAPL"));
+    assert(!Broker::match("market.#.AAPL", "market.a.b.MSFT"));
+}
+
+// 发布大量互不相同的主题 缓存条数不能超过 max_routes
+static void check_route_cache_bounded() {
+    const size_t max_routes = 64;
+    Broker broker(16, OverflowPolicy::DropOldest, max_routes);
+    auto orders = broker.subscribe("order.#");
+
+    // 有订阅者的高基数主题：缓存到上限后清空重来
+    for (int i = 0; i < 10000; i++) {
+        size_t n = broker.publish("order." + std::to_string(i), "x");
+        assert(n == 1);
+        assert(broker.route_cache_size() <= max_routes);
+    }
+    // 没有订阅者的主题记在未命中集合里：同样有界 也不会挤掉已缓存的路由
+    size_t before = broker.route_cache_size();
+    for (int i = 0; i < 10000; i++) {
+        assert(broker.publish("session." + std::to_string(i), "x") == 0);
+        assert(broker.miss_cache_size() <= max_routes);
+    }
+    assert(broker.route_cache_size() == before);
+
+    // 重复发布同一个没人订阅的主题：只有第一次遍历订阅模式
+    uint64_t scans = broker.route_scans();
+    for (int i = 0; i < 1000; i++) assert(broker.publish("session.idle", "x") == 0);
+    assert(broker.route_scans() == scans + 1);
+
+    // 热主题命中缓存后结果不变 订阅变化后缓存失效
+    assert(broker.publish("order.hot", "x") == 1);
+    assert(broker.publish("order.hot", "x") == 1);
+    auto hot = broker.subscribe("order.hot");
+    assert(broker.route_cache_size() == 0 && broker.miss_cache_size() == 0);
+    assert(broker.publish("order.hot", "x") == 2);
+    broker.unsubscribe(hot);
+    assert(broker.publish("order.hot", "x") == 1);
+
+    // 每条都投递到了 order.# 的队列 (容量 16 满了丢最旧的)
+    SubscriberStats st = orders->stats();
+    assert(st.delivered == 10000 + 4);
+    assert(st.lag == 16);
+}
+
+int main() {
+    check_match();
+    check_route_cache_bounded();
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+// MessageQueue 吞吐量对比：旧 pop() / pop(T&) / pop_batch / pop_all
+// 编译: make mq_bench
+// 运行: ./mq_bench [每个生产者的消息数]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mq_tmpl.hpp"
+
+// 改造前的实现 原样保留作为基线：锁内 notify 每次 pop 一条 停止时抛异常
+template <typename T>
+class LegacyMessageQueue{
+public:
+    void push(T&& msg){
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push(std::move(msg));
+        cv_.notify_one();
+    }
+    T pop(){
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]{
+            return !queue_.empty() || should_stop_;
+        });
+        if(should_stop_ && queue_.empty()){
+            throw std::runtime_error("Queue Stoped");
+        }
+        T out = std::move(queue_.front());
+        queue_.pop();
+        return out;
+    }
+    void stop(){
+        std::lock_guard<std::mutex> lock(mutex_);
+        should_stop_ = true;
+        cv_.notify_all();
+    }
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::queue<T> queue_;
+    bool should_stop_ = false;
+};
+
+enum class Mode { Legacy, PopOne, PopBatch, PopAll };
+
+static const char* mode_name(Mode m){
+    switch(m){
+        case Mode::Legacy:   return "legacy pop()";
+        case Mode::PopOne:   return "pop(T&)";
+        case Mode::PopBatch: return "pop_batch(256)";
+        case Mode::PopAll:   return "pop_all";
+    }
+    return "?";
+}
+
+// 每个消费者把收到的值累加 用来校验没有丢消息
+template <typename Queue, typename ConsumeFn>
+static double run(Queue& q, int producers, int consumers, int per_producer,
+                  ConsumeFn consume){
+    std::atomic<uint64_t> sum{0};
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> cons;
+    for(int c = 0; c < consumers; c ++){
+        cons.emplace_back([&]{ sum += consume(q); });
+    }
+    std::vector<std::thread> prods;
+    for(int p = 0; p < producers; p ++){
+        prods.emplace_back([&q, per_producer]{
+            for(int i = 1; i <= per_producer; i ++){
+                q.push(static_cast<uint64_t>(i));
+            }
+        });
+    }
+    for(auto& t : prods) t.join();
+    q.stop();
+    for(auto& t : cons) t.join();
+
+    auto end = std::chrono::steady_clock::now();
+    uint64_t expect = static_cast<uint64_t>(producers) * per_producer * (per_producer + 1ULL) / 2;
+    if(sum.load() != expect){
+        std::fprintf(stderr, "checksum mismatch: %llu != %llu\n",
+                     (unsigned long long)sum.load(), (unsigned long long)expect);
+        std::exit(1);
+    }
+    double sec = std::chrono::duration<double>(end - start).count();
+    return producers * static_cast<double>(per_producer) / sec;
+}
+
+static double bench(Mode mode, int producers, int consumers, int per_producer){
+    if(mode == Mode::Legacy){
+        LegacyMessageQueue<uint64_t> q;
+        return run(q, producers, consumers, per_producer, [](LegacyMessageQueue<uint64_t>& q){
+            uint64_t local = 0;
+            try{
+                while(true) local += q.pop();
+            } catch (const std::runtime_error&){}
+            return local;
+        });
+    }
+    MessageQueue<uint64_t> q;
+    return run(q, producers, consumers, per_producer, [mode](MessageQueue<uint64_t>& q){
+        uint64_t local = 0;
+        if(mode == Mode::PopOne){
+            uint64_t v;
+            while(q.pop(v) == QueueStatus::Ok) local += v;
+            return local;
+        }
+        std::deque<uint64_t> batch;
+        while(true){
+            QueueStatus st = mode == Mode::PopAll
+                ? q.pop_all(batch)
+                : q.pop_batch(batch, 256, std::chrono::milliseconds(10));
+            if(st == QueueStatus::Stopped) break;
+            for(uint64_t v : batch) local += v;
+            batch.clear();
+        }
+        return local;
+    });
+}
+
+int main(int argc, char* argv[]){
+    int per_producer = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const int shapes[][2] = {{1, 1}, {4, 1}, {4, 4}};
+    const Mode modes[] = {Mode::Legacy, Mode::PopOne, Mode::PopBatch, Mode::PopAll};
+
+    std::printf("%-8s %-16s %12s\n", "P x C", "api", "Mmsg/s");
+    for(auto& shape : shapes){
+        for(Mode m : modes){
+            double rate = bench(m, shape[0], shape[1], per_producer);
+            std::printf("%d x %-4d %-16s %12.2f\n", shape[0], shape[1], mode_name(m), rate / 1e6);
+        }
+    }
+    return 0;
+}
@@ -8,59 +8,7 @@
 #include <type_traits>
 #include <utility>
 
-template <typename T>
-class MessageQueue{
-public:
-    // 共有接口方法
-    void push(const T& msg){
-        std::lock_guard<std::mutex> lock(mutex_);
-        queue_.push(msg);
-        cv_.notify_one();
-    }
-    //移动方法
-    void push(T&& msg){
-        std::lock_guard<std::mutex> lock(mutex_);
-        queue_.push(std::move(msg));
-        cv_.notify_one();
-    }
-    T pop(){
-        std::unique_lock<std::mutex> lock(mutex_);
-        // 收到新消息或者停止信号都会被唤醒
-        // 1. 在等待时自动释放锁（避免死锁）
-        // 2. 被唤醒时重新获取锁
-        cv_.wait(lock, [this]{
-            return !queue_.empty() || should_stop_;
-        });
-        if(should_stop_ && queue_.empty()){
-            throw std::runtime_error("Queue Stoped");
-        }
-        T out = std::move(queue_.front());
-        queue_.pop();
-        return out;
-    }
-
-    // 非阻塞弹出
-    bool try_pop(T& result){
-        std::lock_guard<std::mutex> lock(mutex_);
-        if(queue_.empty()) return false;
-        result = std::move(queue_.front());
-        queue_.pop();
-        return true;
-    }
-
-    // 停止队列
-    void stop(){
-        std::lock_guard<std::mutex> lock(mutex_);
-        should_stop_ = true;
-        cv_.notify_all(); //唤醒所有消费者
-    }
-private:
-    mutable std::mutex mutex_;
-    std::condition_variable cv_;
-    std::queue<T> queue_;
-    bool should_stop_ = false;
-};
-
+#include "mq_tmpl.hpp"
 
 /***************消费者 生产者模板*******************/
 template <typename T, typename MessageGenerator>
@@ -200,6 +148,23 @@ int main()
         custom_queue.stop();
         custom_consumer.join();
 
+        std::cout << "\n=============\n";
+
+    }
+
+    // 有界队列：消费者跟不上时挤掉最旧的消息 内存不再无限增长
+    {
+        MessageQueue<int> bounded_queue(4, OverflowPolicy::DropOldest);
+        for(int i = 0; i < 10; i ++){
+            bounded_queue.push(i);
+        }
+        int msg;
+        while(bounded_queue.try_pop(msg)){
+            std::cout << "Consumed : " << msg << " (bounded)" << std::endl;
+        }
+        QueueStats st = bounded_queue.stats();
+        std::cout << "pushed=" << st.pushed << " dropped=" << st.dropped
+                  << " high_water=" << st.high_water << std::endl;
     }
     
     
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+// 出入队结果 停止信号通过返回值上报 热路径上不再 throw
+enum class QueueStatus {
+    Ok,         // 取到了消息 / 消息已入队
+    Timeout,    // 等待超时 队列仍为空
+    Stopped,    // 队列已停止（出队时表示已取空）
+    Full,       // Fail 策略下队列已满 消息被拒绝
+    Dropped     // DropNewest / Sample 策略下本条消息被丢弃
+};
+
+// 有界队列满时的处理策略
+enum class OverflowPolicy {
+    Block,      // 阻塞生产者直到有空位
+    Fail,       // 立即返回 Full
+    DropOldest, // 挤掉队头最旧的一条
+    DropNewest, // 丢弃本次要入队的消息
+    Sample      // 每 sample_rate 条新消息保留一条（挤掉最旧的） 其余丢弃
+};
+
+// 运行统计 用于在线上观察积压情况
+struct QueueStats {
+    uint64_t pushed = 0;      // 成功入队条数
+    uint64_t popped = 0;      // 成功出队条数
+    uint64_t dropped = 0;     // 因溢出被丢弃的条数（新或旧）
+    uint64_t rejected = 0;    // Fail 策略拒绝的条数
+    uint64_t blocked_ns = 0;  // Block 策略下生产者累计阻塞时间
+    size_t high_water = 0;    // 队列长度历史最大值
+    size_t size = 0;          // 快照时的队列长度
+};
+
+template <typename T>
+class MessageQueue{
+public:
+    // capacity 为 0 表示无界（默认行为）
+    MessageQueue() = default;
+    explicit MessageQueue(size_t capacity,
+                          OverflowPolicy policy = OverflowPolicy::Block,
+                          size_t sample_rate = 8)
+        : capacity_(capacity), policy_(policy),
+          sample_rate_(sample_rate ? sample_rate : 1) {}
+
+    // 共有接口方法 停止后不再接收新消息
+    QueueStatus push(const T& msg){
+        return push_impl(msg);
+    }
+    //移动方法
+    QueueStatus push(T&& msg){
+        return push_impl(std::move(msg));
+    }
+
+    // 旧接口：停止后抛异常 保留给已有调用者
+    T pop(){
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_not_empty(lock);
+        if(queue_.empty()){
+            throw std::runtime_error("Queue Stoped");
+        }
+        T out = std::move(queue_.front());
+        queue_.pop_front();
+        after_take(lock, 1);
+        return out;
+    }
+
+    // 阻塞弹出一条 停止且为空时返回 Stopped
+    QueueStatus pop(T& out){
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_not_empty(lock);
+        if(queue_.empty()) return QueueStatus::Stopped;
+        out = std::move(queue_.front());
+        queue_.pop_front();
+        after_take(lock, 1);
+        return QueueStatus::Ok;
+    }
+
+    // 一次加锁取走全部消息 out 为空时直接 swap 整个 deque
+    QueueStatus pop_all(std::deque<T>& out){
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_not_empty(lock);
+        if(queue_.empty()) return QueueStatus::Stopped;
+        after_take(lock, take(out, queue_.size()));
+        return QueueStatus::Ok;
+    }
+
+    // 最多等待 timeout 一次最多取 max 条 追加到 out 尾部
+    template <typename Rep, typename Period>
+    QueueStatus pop_batch(std::deque<T>& out, size_t max,
+                          const std::chrono::duration<Rep, Period>& timeout){
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(queue_.empty() && !should_stop_){
+            ++waiters_;
+            cv_.wait_for(lock, timeout, [this]{
+                return !queue_.empty() || should_stop_;
+            });
+            --waiters_;
+        }
+        if(queue_.empty()){
+            return should_stop_ ? QueueStatus::Stopped : QueueStatus::Timeout;
+        }
+        after_take(lock, take(out, max));
+        return QueueStatus::Ok;
+    }
+
+    // 非阻塞弹出
+    bool try_pop(T& result){
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(queue_.empty()) return false;
+        result = std::move(queue_.front());
+        queue_.pop_front();
+        after_take(lock, 1);
+        return true;
+    }
+
+    size_t size() const{
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    QueueStats stats() const{
+        std::lock_guard<std::mutex> lock(mutex_);
+        QueueStats snapshot = stats_;
+        snapshot.size = queue_.size();
+        return snapshot;
+    }
+
+    // 停止队列
+    void stop(){
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            should_stop_ = true;
+        }
+        cv_.notify_all(); //唤醒所有消费者
+        not_full_.notify_all(); //以及阻塞在满队列上的生产者
+    }
+private:
+    bool full() const{
+        return capacity_ != 0 && queue_.size() >= capacity_;
+    }
+
+    // 锁内只做入队和检查等待者 notify 放到锁外
+    // 否则被唤醒的消费者会立刻撞上生产者还没释放的锁
+    template <typename U>
+    QueueStatus push_impl(U&& msg){
+        bool has_waiter;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(should_stop_) return QueueStatus::Stopped;
+            if(full()){
+                bool evict_oldest = false;
+                switch(policy_){
+                case OverflowPolicy::Block:
+                    wait_not_full(lock);
+                    if(should_stop_) return QueueStatus::Stopped;
+                    break;
+                case OverflowPolicy::Fail:
+                    ++stats_.rejected;
+                    return QueueStatus::Full;
+                case OverflowPolicy::DropNewest:
+                    ++stats_.dropped;
+                    return QueueStatus::Dropped;
+                case OverflowPolicy::Sample:
+                    if(++sample_tick_ % sample_rate_ != 0){
+                        ++stats_.dropped;
+                        return QueueStatus::Dropped;
+                    }
+                    evict_oldest = true;
+                    break;
+                case OverflowPolicy::DropOldest:
+                    evict_oldest = true;
+                    break;
+                }
+                if(evict_oldest){
+                    queue_.pop_front();
+                    ++stats_.dropped;
+                }
+            }
+            queue_.push_back(std::forward<U>(msg));
+            ++stats_.pushed;
+            if(queue_.size() > stats_.high_water) stats_.high_water = queue_.size();
+            has_waiter = waiters_ > 0;
+        }
+        if(has_waiter) cv_.notify_one();
+        return QueueStatus::Ok;
+    }
+
+    // 只有真的阻塞时才计时 不给快路径加 now() 的开销
+    void wait_not_full(std::unique_lock<std::mutex>& lock){
+        auto start = std::chrono::steady_clock::now();
+        ++producer_waiters_;
+        not_full_.wait(lock, [this]{
+            return !full() || should_stop_;
+        });
+        --producer_waiters_;
+        stats_.blocked_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 出队后记账并释放锁 有生产者阻塞时在锁外唤醒
+    void after_take(std::unique_lock<std::mutex>& lock, size_t n){
+        stats_.popped += n;
+        bool wake_producer = producer_waiters_ > 0;
+        lock.unlock();
+        if(!wake_producer) return;
+        if(n > 1) not_full_.notify_all();
+        else not_full_.notify_one();
+    }
+
+    // waiters_ 在锁内增减 生产者在锁内读取 不会丢失唤醒
+    void wait_not_empty(std::unique_lock<std::mutex>& lock){
+        if(!queue_.empty() || should_stop_) return;
+        ++waiters_;
+        cv_.wait(lock, [this]{
+            return !queue_.empty() || should_stop_;
+        });
+        --waiters_;
+    }
+
+    // 调用方持锁 要取走全部且 out 为空时 O(1) 交换 返回取走的条数
+    size_t take(std::deque<T>& out, size_t max){
+        if(max >= queue_.size() && out.empty()){
+            out.swap(queue_);
+            return out.size();
+        }
+        size_t n = 0;
+        for(; n < max && !queue_.empty(); n ++){
+            out.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        return n;
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;        // 等待非空的消费者
+    std::condition_variable not_full_;  // Block 策略下等待空位的生产者
+    std::deque<T> queue_;
+    size_t capacity_ = 0;
+    OverflowPolicy policy_ = OverflowPolicy::Block;
+    size_t sample_rate_ = 8;
+    uint64_t sample_tick_ = 0;
+    size_t waiters_ = 0;
+    size_t producer_waiters_ = 0;
+    bool should_stop_ = false;
+    QueueStats stats_;
+};
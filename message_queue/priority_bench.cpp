@@ -0,0 +1,135 @@
+// 优先级队列基准：严格堆（PriorityMessageQueue） vs 松弛 MultiQueue（RelaxedPriorityQueue）
+// 线程数从 1 增加到 N（N 个生产者 + N 个消费者） 观察吞吐与优先级反转率
+//
+// 反转的定义：消费者取出 A 时 队列里确定还有一条优先级比 A 高的消息 B
+//   B 在 A 开始 pop 之前已经 push 完成 且 B 的 pop 在 A 的 pop 结束之后才开始
+// 这样 B 在 A 出队的整个过程中都在队列里 严格队列本应把 B 交给 A
+// 只用区间端点判断 线程被抢占只会让统计偏保守 不会凭空多出反转
+//
+// 编译: make priority_bench
+// 运行: ./priority_bench [每个生产者消息数] [最大线程数]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "priority_mq.hpp"
+#include "../multi-msg-que/latency_histogram.hpp"
+
+static const int kLevels = 16;  // 优先级 0~15 15 最高
+
+struct Item {
+    int prio;
+    uint32_t id;    // 全局编号 用来找到它的入队时刻
+    bool operator<(const Item& other) const { return prio < other.prio; }
+};
+
+struct Result {
+    double ops_per_sec;
+    double inversion_rate;
+};
+
+// 离线统计：按 push 完成时刻把消息依次 "放进" 集合 按 pop 开始时刻处理查询
+// 每个优先级只需记住已放进集合的消息里最晚的 pop 开始时刻
+static double inversion_rate(const std::vector<int>& prio,
+                             const std::vector<uint64_t>& push_done,
+                             const std::vector<uint64_t>& pop_start,
+                             const std::vector<uint64_t>& pop_done) {
+    size_t n = prio.size();
+    std::vector<uint32_t> by_push(n), by_pop(n);
+    for (size_t i = 0; i < n; i++) by_push[i] = by_pop[i] = static_cast<uint32_t>(i);
+    std::sort(by_push.begin(), by_push.end(),
+              [&](uint32_t a, uint32_t b) { return push_done[a] < push_done[b]; });
+    std::sort(by_pop.begin(), by_pop.end(),
+              [&](uint32_t a, uint32_t b) { return pop_start[a] < pop_start[b]; });
+
+    uint64_t latest_pop_start[kLevels] = {0};
+    uint64_t inversions = 0;
+    size_t next = 0;
+    for (uint32_t a : by_pop) {
+        while (next < n && push_done[by_push[next]] < pop_start[a]) {
+            uint32_t b = by_push[next++];
+            if (pop_start[b] > latest_pop_start[prio[b]]) latest_pop_start[prio[b]] = pop_start[b];
+        }
+        for (int p = prio[a] + 1; p < kLevels; p++) {
+            if (latest_pop_start[p] > pop_done[a]) {
+                inversions++;
+                break;
+            }
+        }
+    }
+    return n ? static_cast<double>(inversions) / n : 0.0;
+}
+
+template <typename Queue>
+static Result run(Queue& q, int threads, int per_producer) {
+    // 按消息编号记录各时刻 每个编号只会被一个线程写
+    size_t n = static_cast<size_t>(threads) * per_producer;
+    std::vector<int> prio(n);
+    std::vector<uint64_t> push_done(n), pop_start(n), pop_done(n);
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < threads; c++) {
+        consumers.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            Item it;
+            uint64_t start = TscClock::now();
+            while (q.pop(it) == QueueStatus::Ok) {
+                uint64_t done = TscClock::now();
+                pop_start[it.id] = start;
+                pop_done[it.id] = done;
+                start = TscClock::now();
+            }
+        });
+    }
+    std::vector<std::thread> producers;
+    for (int p = 0; p < threads; p++) {
+        producers.emplace_back([&, p] {
+            std::mt19937 rng(p + 1);
+            std::uniform_int_distribution<int> dist(0, kLevels - 1);
+            uint32_t base = static_cast<uint32_t>(p) * per_producer;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < per_producer; i++) {
+                int pr = dist(rng);
+                prio[base + i] = pr;
+                q.push(Item{pr, base + i});
+                push_done[base + i] = TscClock::now();
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : producers) t.join();
+    q.close();
+    for (auto& t : consumers) t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    Result r;
+    r.ops_per_sec = n / std::chrono::duration<double>(end - start).count();
+    r.inversion_rate = inversion_rate(prio, push_done, pop_start, pop_done);
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    int per_producer = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int max_threads = argc > 2 ? std::atoi(argv[2]) : 8;
+
+    std::printf("%-8s %-10s %14s %12s\n", "threads", "queue", "ops/s", "inversion");
+    for (int t = 1; t <= max_threads; t *= 2) {
+        PriorityMessageQueue<Item> strict;
+        Result s = run(strict, t, per_producer);
+        std::printf("%-8d %-10s %14.0f %11.3f%%\n", t, "strict", s.ops_per_sec, s.inversion_rate * 100);
+
+        RelaxedPriorityQueue<Item> relaxed(t);
+        Result r = run(relaxed, t, per_producer);
+        std::printf("%-8d %-10s %14.0f %11.3f%%\n", t, "relaxed", r.ops_per_sec, r.inversion_rate * 100);
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "mq_tmpl.hpp"
+#include "../data_structure/heap.hpp"
+
+// 优先级消息队列 接口与 MessageQueue / BlockingQueue 保持一致：push / pop / try_pop / close
+// Compare 语义同 Heap：默认 std::less 大顶堆 "更大" 的消息先出
+
+// ---------------------- 1) 严格优先级：一把锁 + 一个堆 ----------------------
+// 每次 pop 都拿到全局最高优先级 不会有优先级反转 但所有线程争同一把锁
+template <typename T, typename Compare = std::less<T>>
+class PriorityMessageQueue {
+public:
+    explicit PriorityMessageQueue(const Compare& comp = Compare()) : heap_(64, comp) {}
+
+    QueueStatus push(const T& msg) { return push_impl(msg); }
+    QueueStatus push(T&& msg) { return push_impl(std::move(msg)); }
+
+    // 阻塞弹出优先级最高的一条 关闭且为空时返回 Stopped
+    QueueStatus pop(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (heap_.empty() && !closed_) {
+            ++waiters_;
+            cv_.wait(lock, [this] { return !heap_.empty() || closed_; });
+            --waiters_;
+        }
+        if (heap_.empty()) return QueueStatus::Stopped;
+        out = heap_.take_top();
+        return QueueStatus::Ok;
+    }
+
+    bool try_pop(T& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (heap_.empty()) return false;
+        out = heap_.take_top();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.size();
+    }
+
+private:
+    template <typename U>
+    QueueStatus push_impl(U&& msg) {
+        bool has_waiter;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) return QueueStatus::Stopped;
+            heap_.push(std::forward<U>(msg));
+            has_waiter = waiters_ > 0;
+        }
+        if (has_waiter) cv_.notify_one();
+        return QueueStatus::Ok;
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    Heap<T, Compare> heap_;
+    size_t waiters_ = 0;
+    bool closed_ = false;
+};
+
+// ---------------------- 2) 松弛优先级：MultiQueue ----------------------
+// 参考 Rihani/Sanders/Dementiev 的 MultiQueue：c * 线程数 个带锁小堆
+// push 随机挑一个堆；pop 随机挑两个堆 取两者堆顶中优先级更高的那个
+// 锁被分散后吞吐随线程数扩展 代价是 pop 出来的不一定是全局最高（有限的优先级反转）
+template <typename T, typename Compare = std::less<T>>
+class RelaxedPriorityQueue {
+public:
+    explicit RelaxedPriorityQueue(size_t threads, size_t factor = 2,
+                                  const Compare& comp = Compare())
+        : comp_(comp) {
+        size_t n = threads * factor;
+        if (n < 2) n = 2;
+        for (size_t i = 0; i < n; i++) shards_.emplace_back(new Shard(comp));
+    }
+
+    QueueStatus push(const T& msg) { return push_impl(msg); }
+    QueueStatus push(T&& msg) { return push_impl(std::move(msg)); }
+
+    bool try_pop(T& out) {
+        // 先做几轮 "二选一" 都空或抢锁失败再线性扫一遍 保证队列非空时一定能取到
+        for (int attempt = 0; attempt < 4; attempt++) {
+            if (size_.load(std::memory_order_acquire) == 0) return false;
+            Shard& a = *shards_[next_index()];
+            Shard& b = *shards_[next_index()];
+            if (pop_better(a, b, out)) return true;
+        }
+        for (auto& s : shards_) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            if (!s->heap.empty()) {
+                take(*s, out);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 队列为空时睡在条件变量上 有数据或关闭时被唤醒
+    QueueStatus pop(T& out) {
+        while (true) {
+            if (try_pop(out)) return QueueStatus::Ok;
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            // 先读 closed_ 再读 size_ 与 push 端 "先加 size_ 再看 closed_" 配对
+            // 看到已关闭且随后 size_ 为 0 时 之后的 push 一定能看到 closed_ 并回滚 不会有消息滞留
+            bool closed = closed_.load();
+            if (size_.load() != 0) continue;
+            if (closed) return QueueStatus::Stopped;
+            // 先登记再检查 size_ 与 push 端 "先加 size_ 再看 sleepers_" 配对（都是 seq_cst）
+            // 两边至少有一方能看到对方 不会丢唤醒
+            ++sleepers_;
+            sleep_cv_.wait(lock, [this] {
+                return size_.load() != 0 || closed_.load();
+            });
+            --sleepers_;
+        }
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            closed_.store(true);
+        }
+        sleep_cv_.notify_all();
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Shard {
+        explicit Shard(const Compare& comp) : heap(16, comp) {}
+        std::mutex mutex;
+        Heap<T, Compare> heap;
+    };
+
+    // 线程私有的 xorshift 避免随机数发生器本身成为共享热点
+    size_t next_index() {
+        thread_local uint64_t state =
+            0x9E3779B97F4A7C15ULL ^ reinterpret_cast<uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<size_t>(state % shards_.size());
+    }
+
+    template <typename U>
+    QueueStatus push_impl(U&& msg) {
+        // 先占计数再入堆 size_ 不会因为 "先被取走再计数" 而下溢
+        // 占计数之后再检查 closed_：先查后加的话 查完到入堆之间 close() 和最后一个消费者退出
+        // 都可能发生 消息入堆后再没人取 (两者都是 seq_cst 要么这里看到关闭 要么消费者看到 size_ > 0)
+        size_.fetch_add(1);
+        if (closed_.load()) {
+            size_.fetch_sub(1);
+            return QueueStatus::Stopped;
+        }
+        while (true) {
+            Shard& s = *shards_[next_index()];
+            std::unique_lock<std::mutex> lock(s.mutex, std::try_to_lock);
+            if (!lock.owns_lock()) continue;    // 被占用就换一个堆 不排队
+            s.heap.push(std::forward<U>(msg));
+            break;
+        }
+        // 只有确实有消费者在睡时才碰 sleep_mutex_ 快路径上没有全局锁
+        // 加一下锁是为了等对方真正进入 wait 再 notify
+        if (sleepers_.load() > 0) {
+            { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+            sleep_cv_.notify_one();
+        }
+        return QueueStatus::Ok;
+    }
+
+    void take(Shard& s, T& out) {
+        out = s.heap.take_top();
+        size_.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool pop_better(Shard& a, Shard& b, T& out) {
+        if (&a == &b) {
+            std::unique_lock<std::mutex> la(a.mutex, std::try_to_lock);
+            if (!la.owns_lock() || a.heap.empty()) return false;
+            take(a, out);
+            return true;
+        }
+        // 两把锁都用 try_lock 抢不到就放弃 不会死锁
+        Shard& first = &a < &b ? a : b;
+        Shard& second = &a < &b ? b : a;
+        std::unique_lock<std::mutex> l1(first.mutex, std::try_to_lock);
+        if (!l1.owns_lock()) return false;
+        std::unique_lock<std::mutex> l2(second.mutex, std::try_to_lock);
+        if (!l2.owns_lock()) {
+            if (first.heap.empty()) return false;
+            take(first, out);
+            return true;
+        }
+        if (first.heap.empty() && second.heap.empty()) return false;
+        if (first.heap.empty()) { take(second, out); return true; }
+        if (second.heap.empty()) { take(first, out); return true; }
+        // comp(x, y) 为真表示 y 优先级更高
+        if (comp_(first.heap.top(), second.heap.top())) take(second, out);
+        else take(first, out);
+        return true;
+    }
+
+    Compare comp_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<size_t> size_{0};
+    std::atomic<bool> closed_{false};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t> sleepers_{0};
+};
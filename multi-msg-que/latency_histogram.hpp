@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// ---------------------- TSC 时钟 ----------------------
+// x86 上直接读 rdtsc（约 20 个周期 比 clock_gettime 便宜得多）
+// 要求 CPU 支持 invariant TSC 且各核 TSC 同步（近十年的 x86 服务器基本都满足）
+// 其它架构退化为 steady_clock 纳秒
+class TscClock {
+public:
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // 每个 tick 多少纳秒 用 steady_clock 校准一次
+    static double ns_per_tick() {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+private:
+    static double calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t c1 = __rdtsc();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return ns / static_cast<double>(c1 - c0);
+#else
+        return 1.0;
+#endif
+    }
+};
+
+// ---------------------- HDR 风格直方图 ----------------------
+// 对数-线性分桶：每个 2 的幂区间再均分 32 个子桶 相对误差 < 1/32（约 3%）
+// 记录只是一次 clz + 数组自增 适合在热路径上每条消息都记
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 5;
+    static constexpr uint64_t kSubCount = 1ULL << kSubBits;
+
+    LatencyHistogram() : counts_(kSubCount * (64 - kSubBits + 1), 0) {}
+
+    void record(uint64_t value) {
+        counts_[index_of(value)]++;
+        total_++;
+        if (value > max_) max_ = value;
+    }
+
+    // 合并其它线程的直方图
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts_.size(); i++) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+
+    // q 取 0~1 返回对应桶的上界（与 HdrHistogram 一致 宁可高估不低估）
+    uint64_t percentile(double q) const {
+        if (total_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total_));
+        if (rank >= total_) rank = total_ - 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            seen += counts_[i];
+            if (seen > rank) {
+                uint64_t upper = upper_bound_of(i);
+                return upper < max_ ? upper : max_;
+            }
+        }
+        return max_;
+    }
+
+private:
+    static size_t index_of(uint64_t v) {
+        if (v < kSubCount) return static_cast<size_t>(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - kSubBits;     // v >> shift 落在 [32, 64)
+        return static_cast<size_t>(kSubCount + shift * kSubCount + ((v >> shift) - kSubCount));
+    }
+
+    static uint64_t upper_bound_of(size_t idx) {
+        if (idx < kSubCount) return idx;
+        size_t shift = (idx - kSubCount) / kSubCount;
+        uint64_t sub = (idx - kSubCount) % kSubCount + kSubCount;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+};
@@ -0,0 +1,209 @@
+// 队列基准：BlockingQueue / MPMCQueue / MessageQueue
+// 扫描 生产者数 x 消费者数 x payload 大小 x 容量
+// 每条消息带上入队前的 TSC 时间戳 出队后算出端到端延迟记入直方图
+// 输出 CSV：p50/p99/p99.9 延迟（ns）与吞吐（ops/s）
+//
+// 编译: make queue_bench
+// 运行: ./queue_bench [-n 每个生产者消息数] [-q blocking,mpmc,mq]
+//                     [-p 1,2,4] [-c 1,2,4] [-s 16,256,1024] [-k 64,1024]
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "mpmc_queue.hpp"
+#include "latency_histogram.hpp"
+#include "../message_queue/mq_tmpl.hpp"
+
+template <size_t N>
+struct BenchMsg {
+    uint64_t stamp;
+    std::array<char, N> payload;
+};
+
+// ---------------------- 统一三种队列的接口 ----------------------
+// push 在队列满时阻塞/自旋；pop 返回 false 表示生产者已结束且队列已空
+
+template <typename T>
+struct BlockingAdapter {
+    BlockingQueue<T> q;
+    explicit BlockingAdapter(size_t cap) : q(cap) {}
+    void push(T&& v) { q.enqueue(std::move(v)); }
+    bool pop(T& out) { return q.dequeue(out); }
+    void producers_done() { q.close(); }
+};
+
+template <typename T>
+struct MpmcAdapter {
+    MPMCQueue<T> q;
+    std::atomic<bool> done{false};
+    explicit MpmcAdapter(size_t cap) : q(cap) {}
+    void push(T&& v) {
+        while (!q.try_enqueue(std::move(v))) std::this_thread::yield();
+    }
+    bool pop(T& out) {
+        while (!q.try_dequeue(out)) {
+            // 先看 done 再重试一次 避免生产者最后一条刚入队就被漏掉
+            if (done.load(std::memory_order_acquire)) return q.try_dequeue(out);
+            std::this_thread::yield();
+        }
+        return true;
+    }
+    void producers_done() { done.store(true, std::memory_order_release); }
+};
+
+template <typename T>
+struct MessageQueueAdapter {
+    MessageQueue<T> q;
+    explicit MessageQueueAdapter(size_t cap) : q(cap, OverflowPolicy::Block) {}
+    void push(T&& v) { q.push(std::move(v)); }
+    bool pop(T& out) { return q.pop(out) == QueueStatus::Ok; }
+    void producers_done() { q.stop(); }
+};
+
+struct Config {
+    const char* queue;
+    int producers;
+    int consumers;
+    size_t payload;
+    size_t capacity;
+    int per_producer;
+};
+
+template <typename Queue, size_t N>
+static void run_one(const Config& cfg) {
+    using Msg = BenchMsg<N>;
+    Queue q(cfg.capacity);
+    std::vector<LatencyHistogram> hists(cfg.consumers);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    const int threads = cfg.producers + cfg.consumers;
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < cfg.consumers; c++) {
+        consumers.emplace_back([&, c] {
+            LatencyHistogram& h = hists[c];
+            Msg m;
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (q.pop(m)) {
+                h.record(TscClock::now() - m.stamp);
+            }
+        });
+    }
+    std::vector<std::thread> producers;
+    for (int p = 0; p < cfg.producers; p++) {
+        producers.emplace_back([&] {
+            Msg m;
+            std::memset(m.payload.data(), 'x', N);
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < cfg.per_producer; i++) {
+                m.stamp = TscClock::now();
+                q.push(std::move(m));
+            }
+        });
+    }
+
+    while (ready.load() < threads) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : producers) t.join();
+    q.producers_done();
+    for (auto& t : consumers) t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    LatencyHistogram all;
+    for (auto& h : hists) all.merge(h);
+    double sec = std::chrono::duration<double>(end - start).count();
+    double tick = TscClock::ns_per_tick();
+    std::printf("%s,%d,%d,%zu,%zu,%llu,%.0f,%.0f,%.0f,%.0f,%.0f\n",
+                cfg.queue, cfg.producers, cfg.consumers, cfg.payload, cfg.capacity,
+                (unsigned long long)all.count(), all.count() / sec,
+                all.percentile(0.50) * tick, all.percentile(0.99) * tick,
+                all.percentile(0.999) * tick, all.max() * tick);
+    std::fflush(stdout);
+}
+
+template <size_t N>
+static void dispatch_queue(const Config& cfg) {
+    using Msg = BenchMsg<N>;
+    std::string name = cfg.queue;
+    if (name == "blocking") run_one<BlockingAdapter<Msg>, N>(cfg);
+    else if (name == "mpmc") run_one<MpmcAdapter<Msg>, N>(cfg);
+    else if (name == "mq") run_one<MessageQueueAdapter<Msg>, N>(cfg);
+    else std::fprintf(stderr, "unknown queue: %s\n", cfg.queue);
+}
+
+// payload 大小是模板参数 这样消息是定长数组 不会引入堆分配的噪声
+static void dispatch(const Config& cfg) {
+    switch (cfg.payload) {
+        case 16:   dispatch_queue<16>(cfg); break;
+        case 64:   dispatch_queue<64>(cfg); break;
+        case 256:  dispatch_queue<256>(cfg); break;
+        case 1024: dispatch_queue<1024>(cfg); break;
+        case 4096: dispatch_queue<4096>(cfg); break;
+        default:
+            std::fprintf(stderr, "unsupported payload %zu (16/64/256/1024/4096)\n", cfg.payload);
+    }
+}
+
+static std::vector<std::string> split(const char* s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+static std::vector<size_t> split_num(const char* s) {
+    std::vector<size_t> out;
+    for (auto& item : split(s)) out.push_back(std::strtoul(item.c_str(), nullptr, 10));
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    int per_producer = 100000;
+    std::vector<std::string> queues = {"blocking", "mpmc", "mq"};
+    std::vector<size_t> producers = {1, 4};
+    std::vector<size_t> consumers = {1, 4};
+    std::vector<size_t> payloads = {16, 256, 1024};
+    std::vector<size_t> capacities = {64, 4096};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:q:p:c:s:k:h")) != -1) {
+        switch (opt) {
+            case 'n': per_producer = std::atoi(optarg); break;
+            case 'q': queues = split(optarg); break;
+            case 'p': producers = split_num(optarg); break;
+            case 'c': consumers = split_num(optarg); break;
+            case 's': payloads = split_num(optarg); break;
+            case 'k': capacities = split_num(optarg); break;
+            default:
+                std::fprintf(stderr,
+                    "Usage: %s [-n msgs] [-q blocking,mpmc,mq] [-p 1,4] [-c 1,4] "
+                    "[-s 16,256,1024] [-k 64,4096]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    TscClock::ns_per_tick();    // 先校准 不计入第一轮
+    std::printf("queue,producers,consumers,payload,capacity,msgs,ops_per_sec,"
+                "p50_ns,p99_ns,p999_ns,max_ns\n");
+    for (auto& q : queues)
+        for (size_t p : producers)
+            for (size_t c : consumers)
+                for (size_t s : payloads)
+                    for (size_t k : capacities)
+                        dispatch({q.c_str(), (int)p, (int)c, s, k, per_producer});
+    return 0;
+}
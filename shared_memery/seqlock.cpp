@@ -0,0 +1,67 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "seqlock.hpp"
+
+// 与 main.cpp / main.c 相同的共享数据 换成 seqlock 保护
+struct SharedData {
+    int counter;
+    char message[256];
+};
+
+int main() {
+    const char* SHARED_MEMORY_NAME = "/SeqlockSharedData";
+    SeqlockChannel<SharedData>::remove(SHARED_MEMORY_NAME);    // 清理之前的残留
+
+    try {
+        SeqlockChannel<SharedData> channel(SHARED_MEMORY_NAME, true);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+
+        if (pid == 0) { // 子进程（写入者）：从不等待读者
+            SeqlockChannel<SharedData> writer(SHARED_MEMORY_NAME, false);
+            SharedData data;
+            for (int i = 1; i <= 5; i++) {
+                data.counter = i;
+                snprintf(data.message, sizeof(data.message), "Child update #%d", i);
+                writer.write(data);
+                std::cout << "[Writer] Updated: counter=" << i
+                          << ", message=" << data.message << std::endl;
+                usleep(100 * 1000);
+            }
+            _exit(0);
+        }
+
+        // 父进程（读取者）：只在版本号变化时拷贝快照
+        uint32_t last_version = channel.version();
+        SharedData snapshot{};  // 值初始化：第一次读到新版本之前 counter 为 0
+        do {
+            uint32_t v = channel.version();
+            if (v != last_version && !(v & 1)) {
+                unsigned retries = channel.read(snapshot, &last_version);
+                std::cout << "[Reader] Current: counter=" << snapshot.counter
+                          << ", message=" << snapshot.message
+                          << " (retries=" << retries << ")" << std::endl;
+            }
+            usleep(10 * 1000);
+        } while (snapshot.counter < 5);
+
+        waitpid(pid, nullptr, 0);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        SeqlockChannel<SharedData>::remove(SHARED_MEMORY_NAME);
+        return EXIT_FAILURE;
+    }
+
+    SeqlockChannel<SharedData>::remove(SHARED_MEMORY_NAME);
+    std::cout << "Resources cleaned up" << std::endl;
+    return EXIT_SUCCESS;
+}
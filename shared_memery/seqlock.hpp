@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 基于 seqlock 的单写多读快照通道（POSIX 共享内存）
+// 写者：seq 变奇数 -> 写数据 -> seq 变偶数 全程不等任何读者
+// 读者：读 seq -> 拷贝数据 -> 再读 seq 两次相同且为偶数才算拿到完整快照 否则重试
+// 读者之间、读者与写者之间都没有锁 高频轮询的读者不会拖慢写者
+// 限制：只能有一个写者；T 必须可平凡拷贝（按字节拷贝即可得到副本）
+template <typename T>
+class SeqlockChannel {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqlockChannel requires a trivially copyable payload");
+
+    struct Layout {
+        alignas(64) std::atomic<uint32_t> seq;
+        alignas(64) T data;     // 与 seq 分开两条 cache line 写者改数据时不反复让读者的 seq 失效
+    };
+
+public:
+    // create 为 true 时创建并初始化（写者调用） 否则打开已存在的
+    SeqlockChannel(const char* name, bool create) {
+        int flags = create ? (O_CREAT | O_RDWR) : O_RDWR;
+        int fd = shm_open(name, flags, 0666);
+        if (fd < 0) throw std::runtime_error(std::string("shm_open failed: ") + name);
+        if (create && ftruncate(fd, sizeof(Layout)) < 0) {
+            close(fd);
+            throw std::runtime_error("ftruncate failed");
+        }
+        void* p = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("mmap failed");
+        layout_ = static_cast<Layout*>(p);
+        if (create) {
+            std::memset(static_cast<void*>(&layout_->data), 0, sizeof(T));
+            layout_->seq.store(0, std::memory_order_release);
+        }
+    }
+
+    ~SeqlockChannel() { munmap(layout_, sizeof(Layout)); }
+
+    SeqlockChannel(const SeqlockChannel&) = delete;
+    SeqlockChannel& operator=(const SeqlockChannel&) = delete;
+
+    static void remove(const char* name) { shm_unlink(name); }
+
+    // 只允许一个写者
+    void write(const T& value) {
+        uint32_t s = layout_->seq.load(std::memory_order_relaxed);
+        layout_->seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);    // 奇数 seq 先于数据可见
+        std::memcpy(static_cast<void*>(&layout_->data), &value, sizeof(T));
+        layout_->seq.store(s + 2, std::memory_order_release);   // 数据先于偶数 seq 可见
+    }
+
+    // 读一次 读到被撕裂的数据返回 false
+    // 成功时 version 非空则写入这份快照对应的 (偶数) 版本号
+    bool try_read(T& out, uint32_t* version = nullptr) const {
+        uint32_t s0 = layout_->seq.load(std::memory_order_acquire);
+        if (s0 & 1) return false;   // 写者正在写
+        std::memcpy(&out, static_cast<const void*>(&layout_->data), sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);    // 数据读取先于第二次读 seq
+        if (layout_->seq.load(std::memory_order_relaxed) != s0) return false;
+        if (version) *version = s0;
+        return true;
+    }
+
+    // 读到一份完整快照为止 返回重试次数
+    // 要记住 "读到了哪个版本" 时用 version 输出 不要事后再调 version()：两次之间写者可能又写完了一次
+    unsigned read(T& out, uint32_t* version = nullptr) const {
+        unsigned retries = 0;
+        while (!try_read(out, version)) {
+            retries++;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        return retries;
+    }
+
+    // 当前版本号 读者可以用它判断是否有新数据 不必每次都拷贝
+    uint32_t version() const { return layout_->seq.load(std::memory_order_acquire); }
+
+private:
+    Layout* layout_;
+};
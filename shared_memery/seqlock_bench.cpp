@@ -0,0 +1,223 @@
+// 多进程基准：1 个写进程 + N 个读进程 读者全速轮询 SharedData 快照
+// 对比三种保护方式：seqlock / boost named_mutex（main.cpp）/ SysV 信号量（main.c）
+// 统计：读者每秒拿到的快照数、写者单次更新延迟 p50 / p99 / max
+//
+// 编译: make seqlock_bench
+// 运行: ./seqlock_bench [读进程数] [持续秒数]
+#include <boost/interprocess/sync/named_mutex.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <vector>
+#include <sys/ipc.h>
+#include <sys/mman.h>
+#include <sys/sem.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "seqlock.hpp"
+
+using namespace boost::interprocess;
+
+struct SharedData {
+    int counter;
+    char message[256];
+};
+
+// 读写进程把结果写回这块匿名共享内存
+struct BenchResult {
+    std::atomic<bool> stop;
+    std::atomic<unsigned long long> reads;
+    std::atomic<unsigned long long> retries;
+    unsigned long long writes;
+    long long write_p50;
+    long long write_p99;
+    long long write_max;
+};
+
+static long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ---------------------- 三种保护方式 ----------------------
+// 每种都提供：进程内 attach() / write(data) / read(data)（返回重试次数）
+
+static const char* SEQLOCK_NAME = "/SeqlockBench";
+static const char* MUTEX_NAME = "SeqlockBenchMutex";
+
+struct SeqlockMode {
+    const char* name() const { return "seqlock"; }
+    void setup() { SeqlockChannel<SharedData>::remove(SEQLOCK_NAME); owner_.reset(new SeqlockChannel<SharedData>(SEQLOCK_NAME, true)); }
+    void teardown() { owner_.reset(); SeqlockChannel<SharedData>::remove(SEQLOCK_NAME); }
+    void attach() { chan_.reset(new SeqlockChannel<SharedData>(SEQLOCK_NAME, false)); }
+    void write(const SharedData& d) { chan_->write(d); }
+    unsigned read(SharedData& d) { return chan_->read(d); }
+
+    std::unique_ptr<SeqlockChannel<SharedData>> owner_, chan_;
+};
+
+// fork 前 mmap 的共享页 子进程继承
+static SharedData* map_shared_data() {
+    void* p = mmap(nullptr, sizeof(SharedData), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    return static_cast<SharedData*>(p);
+}
+
+struct MutexMode {
+    const char* name() const { return "named_mutex"; }
+    void setup() {
+        named_mutex::remove(MUTEX_NAME);
+        named_mutex(create_only, MUTEX_NAME);
+        data_ = map_shared_data();
+    }
+    void teardown() {
+        munmap(data_, sizeof(SharedData));
+        named_mutex::remove(MUTEX_NAME);
+    }
+    void attach() { mutex_.reset(new named_mutex(open_only, MUTEX_NAME)); }
+    void write(const SharedData& d) {
+        scoped_lock<named_mutex> lock(*mutex_);
+        *data_ = d;
+    }
+    unsigned read(SharedData& d) {
+        scoped_lock<named_mutex> lock(*mutex_);
+        d = *data_;
+        return 0;
+    }
+
+    SharedData* data_ = nullptr;
+    std::unique_ptr<named_mutex> mutex_;
+};
+
+struct SemMode {
+    const char* name() const { return "sysv_sem"; }
+    void setup() {
+        sem_id_ = semget(IPC_PRIVATE, 1, IPC_CREAT | 0600);
+        if (sem_id_ < 0) {
+            perror("semget");
+            exit(1);
+        }
+        semctl(sem_id_, 0, SETVAL, 1);
+        data_ = map_shared_data();
+    }
+    void teardown() {
+        munmap(data_, sizeof(SharedData));
+        semctl(sem_id_, 0, IPC_RMID);
+    }
+    void attach() {}
+    void write(const SharedData& d) {
+        lock();
+        *data_ = d;
+        unlock();
+    }
+    unsigned read(SharedData& d) {
+        lock();
+        d = *data_;
+        unlock();
+        return 0;
+    }
+    void lock() {
+        struct sembuf op = {0, -1, 0};
+        semop(sem_id_, &op, 1);
+    }
+    void unlock() {
+        struct sembuf op = {0, 1, 0};
+        semop(sem_id_, &op, 1);
+    }
+
+    int sem_id_ = -1;
+    SharedData* data_ = nullptr;
+};
+
+// ---------------------- 测试流程 ----------------------
+template <typename Mode>
+static void run(Mode& mode, int readers, int seconds, BenchResult* res) {
+    new (res) BenchResult();
+    mode.setup();
+
+    std::vector<pid_t> pids;
+    // 读进程：全速轮询 每次拿完整快照
+    for (int r = 0; r < readers; r++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            mode.attach();
+            SharedData snap;
+            unsigned long long reads = 0, retries = 0;
+            while (!res->stop.load(std::memory_order_relaxed)) {
+                retries += mode.read(snap);
+                reads++;
+            }
+            res->reads += reads;
+            res->retries += retries;
+            _exit(0);
+        }
+        pids.push_back(pid);
+    }
+
+    // 写进程：全速更新 记录每次更新（含等锁）的耗时
+    pid_t writer = fork();
+    if (writer == 0) {
+        mode.attach();
+        std::vector<long long> lat;
+        lat.reserve(1 << 20);
+        SharedData d;
+        for (int i = 1; !res->stop.load(std::memory_order_relaxed); i++) {
+            d.counter = i;
+            snprintf(d.message, sizeof(d.message), "Update #%d", i);
+            long long t0 = now_ns();
+            mode.write(d);
+            long long t1 = now_ns();
+            if (lat.size() < lat.capacity()) lat.push_back(t1 - t0);
+            res->writes++;
+        }
+        std::sort(lat.begin(), lat.end());
+        if (!lat.empty()) {
+            res->write_p50 = lat[lat.size() / 2];
+            res->write_p99 = lat[lat.size() * 99 / 100];
+            res->write_max = lat.back();
+        }
+        _exit(0);
+    }
+    pids.push_back(writer);
+
+    sleep(seconds);
+    res->stop.store(true);
+    for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+    mode.teardown();
+
+    printf("%-12s %8d %16.0f %12llu %12.0f %10lld %10lld %10lld\n",
+           mode.name(), readers, res->reads.load() / (double)seconds, res->retries.load(),
+           res->writes / (double)seconds, res->write_p50, res->write_p99, res->write_max);
+}
+
+int main(int argc, char* argv[]) {
+    int readers = argc > 1 ? atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? atoi(argv[2]) : 3;
+
+    void* p = mmap(nullptr, sizeof(BenchResult), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    BenchResult* res = static_cast<BenchResult*>(p);
+
+    printf("%-12s %8s %16s %12s %12s %10s %10s %10s\n", "mode", "readers", "reads/s",
+           "retries", "writes/s", "w p50 ns", "w p99 ns", "w max ns");
+    SeqlockMode seqlock;
+    run(seqlock, readers, seconds, res);
+    MutexMode mutex;
+    run(mutex, readers, seconds, res);
+    SemMode sem;
+    run(sem, readers, seconds, res);
+    return 0;
+}